@@ -15,6 +15,7 @@ c++ -std=c++17 -O3 -DNDEBUG -Isrc \
     -arch arm64 -arch x86_64 \
     src/main.cpp src/uci.cpp src/board.cpp src/movegen.cpp \
     src/search.cpp src/opening_book.cpp src/eco_book.cpp \
+    src/mapped_file.cpp src/tbprobe.cpp src/bitbase.cpp src/endgame.cpp src/evaluate.cpp src/bench.cpp src/perft.cpp src/notation.cpp src/packed_position.cpp src/datagen.cpp src/batch.cpp src/polyglot.cpp src/pgn.cpp src/output.cpp src/options.cpp \
     -o "$OUT/chess_engine"
 strip "$OUT/chess_engine"
 
@@ -1,27 +1,19 @@
 #!/usr/bin/env python3
 """Regenerate src/eco_book.cpp from src/eco.pgn.
 
-The opening book is embedded into the binary so a single executable file can
-be shipped. Run this after editing src/eco.pgn, then rebuild.
+The opening book is compiled into the binary as a sorted array of
+(zobrist key, weight, packed move) records, so a single executable file can
+be shipped and nothing is parsed at startup. The records are produced by the
+engine's own PGN reader (tools/embed_book), which this script builds in
+./build and runs. Run it after editing src/eco.pgn, then rebuild.
 """
 import pathlib
+import subprocess
 
 root = pathlib.Path(__file__).resolve().parent.parent
-data = (root / "src" / "eco.pgn").read_bytes()
+build = root / "build"
 
-lines = []
-for i in range(0, len(data), 20):
-    lines.append(", ".join(str(b) for b in data[i:i + 20]) + ",")
-body = "\n    ".join(lines)
-
-(root / "src" / "eco_book.cpp").write_text(f"""\
-// Generated by scripts/embed_book.py from src/eco.pgn — do not edit by hand.
-#include "eco_book.h"
-
-const unsigned char ECO_BOOK_DATA[] = {{
-    {body}
-}};
-const std::size_t ECO_BOOK_SIZE = sizeof(ECO_BOOK_DATA);
-""")
-
-print(f"embedded {len(data)} bytes into src/eco_book.cpp")
+subprocess.run(["cmake", "-S", str(root), "-B", str(build)], check=True)
+subprocess.run(["cmake", "--build", str(build), "--target", "embed_book"], check=True)
+subprocess.run([str(build / "tools" / "embed_book"),
+                str(root / "src" / "eco.pgn"), str(root / "src" / "eco_book.cpp")], check=True)
@@ -0,0 +1,141 @@
+#include "batch.h"
+#include "board.h"
+#include "evaluate.h"
+#include "search.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+    std::string jsonString(const std::string& s) {
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') out += '\\';
+            if (static_cast<unsigned char>(c) < 0x20) continue;
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    // FEN with the move counters optional
+    bool parseFen(const std::string& line, Board& board) {
+        std::istringstream iss(line);
+        std::vector<std::string> f;
+        std::string w;
+        while (f.size() < 6 && iss >> w) f.push_back(w);
+        if (f.size() < 4) return false;
+        std::string fen = f[0] + " " + f[1] + " " + f[2] + " " + f[3];
+        fen += f.size() == 6 ? " " + f[4] + " " + f[5] : " 0 1";
+        return board.fromFEN(fen);
+    }
+
+    std::string answer(const BatchRunner::Options& o, SearchEngine& engine, const std::string& line) {
+        std::ostringstream json;
+        json << "{\"fen\": " << jsonString(line);
+        Board board;
+        if (!parseFen(line, board)) {
+            json << ", \"error\": \"invalid FEN\"}";
+            return json.str();
+        }
+        int sign = board.getSideToMove() == Color::WHITE ? 1 : -1;
+
+        switch (o.mode) {
+            case BatchRunner::Mode::Eval:
+                json << ", \"eval\": " << Evaluation::evaluate(board);
+                break;
+            case BatchRunner::Mode::QSearch:
+                json << ", \"qsearch\": " << sign * engine.qsearch(board);
+                break;
+            case BatchRunner::Mode::Search: {
+                engine.newGame();
+                SearchResult r = engine.search(board, o.depth);
+                bool hasMove = r.bestMove.from != r.bestMove.to;
+                json << ", \"bestmove\": " << jsonString(hasMove ? moveToUci(r.bestMove) : "")
+                     << ", \"score\": " << sign * r.score
+                     << ", \"depth\": " << r.depth << ", \"nodes\": " << r.nodesSearched;
+                if (std::abs(r.score) > MATE_SCORE - 1000) {
+                    int mateIn = (MATE_SCORE - std::abs(r.score) + 1) / 2;
+                    json << ", \"mate\": " << (sign * r.score > 0 ? mateIn : -mateIn);
+                }
+                break;
+            }
+        }
+        json << "}";
+        return json.str();
+    }
+}
+
+long long BatchRunner::run(const Options& options, std::istream& in, std::ostream& out) {
+    int threads = options.threads > 0 ? options.threads
+                                      : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const size_t maxQueued = static_cast<size_t>(threads) * 64;
+
+    std::mutex mutex;
+    std::condition_variable queueReady, queueSpace;
+    std::deque<std::pair<long long, std::string>> queue;
+    bool inputDone = false;
+
+    // Finished answers wait here until every earlier line is written
+    std::map<long long, std::string> finished;
+    long long nextOut = 0;
+
+    auto worker = [&] {
+        SearchEngine engine;
+        engine.setHashSize(options.hashMB);
+        engine.setQuietMode(true);
+        engine.setTimeLimit(0);
+        for (;;) {
+            std::pair<long long, std::string> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                queueReady.wait(lock, [&] { return !queue.empty() || inputDone; });
+                if (queue.empty()) return;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            queueSpace.notify_one();
+
+            std::string result = answer(options, engine, job.second);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.emplace(job.first, std::move(result));
+            bool wrote = false;
+            for (auto it = finished.begin(); it != finished.end() && it->first == nextOut;
+                 it = finished.erase(it), nextOut++) {
+                out << it->second << '\n';
+                wrote = true;
+            }
+            if (wrote) out.flush();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back(worker);
+
+    long long count = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.find_first_not_of(" \t") == std::string::npos) continue;
+        std::unique_lock<std::mutex> lock(mutex);
+        queueSpace.wait(lock, [&] { return queue.size() < maxQueued; });
+        queue.emplace_back(count++, line);
+        lock.unlock();
+        queueReady.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inputDone = true;
+    }
+    queueReady.notify_all();
+    for (std::thread& t : pool) t.join();
+    return count;
+}
@@ -0,0 +1,37 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <istream>
+#include <ostream>
+
+// Bulk position labelling (`chess_engine batch`): one FEN per input line,
+// one JSON object per output line, in input order.
+//
+// Lines are shared out to a pool of threads, each with its own
+// SearchEngine, and written as soon as every earlier line is done, so a
+// script can stream thousands of positions through at full core speed, or
+// feed one line at a time and read each answer back. Scores are
+// white-relative centipawns:
+//
+//   eval     {"fen": "...", "eval": 23}
+//   qsearch  {"fen": "...", "qsearch": 23}
+//   search   {"fen": "...", "bestmove": "e2e4", "score": 31, "depth": 8, "nodes": 12345}
+//            (mate scores also carry "mate": moves, negative when white is mated)
+//
+// A line that is not a valid FEN gives {"fen": "...", "error": "invalid FEN"}.
+class BatchRunner {
+public:
+    enum class Mode { Eval, QSearch, Search };
+
+    struct Options {
+        Mode mode   = Mode::Eval;
+        int depth   = 8;      // Search mode
+        int threads = 0;      // 0 = all hardware threads
+        int hashMB  = 16;     // per thread
+    };
+
+    // Runs until the end of input; returns the number of lines answered
+    static long long run(const Options& options, std::istream& in, std::ostream& out);
+};
+
+#endif // BATCH_H
@@ -0,0 +1,83 @@
+#include "bench.h"
+#include "board.h"
+#include "search.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+const std::vector<std::string>& Benchmark::positions() {
+    // Opening, middlegame (quiet and tactical) and endgame positions; the
+    // first ten match scripts/bench.py.
+    static const std::vector<std::string> fens = {
+        "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r2q1rk1/ppp2ppp/3p1n2/2bPp3/2B1P1b1/2NP1N2/PPP2PPP/R1BQ1RK1 w - - 4 8",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "8/8/1p2k3/p1p2p2/P1P2P2/1P2K3/8/8 w - - 0 1",
+        "8/3k4/8/3K4/3P4/8/8/8 w - - 0 1",
+        "6k1/5ppp/1q6/8/8/1Q6/5PPP/6K1 w - - 0 1",
+        "2r3k1/pp3ppp/8/3p4/3P4/8/PP3PPP/2R3K1 w - - 0 1",
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r1bq1rk1/pp2ppbp/2np1np1/8/3NP3/2N1BP2/PPPQ2PP/R3KB1R w KQ - 3 9",
+        "r2qr1k1/1b1nbppp/p2p1n2/1pp1p3/4P3/1BPP1N1P/PP1N1PP1/R1BQR1K1 w - - 0 12",
+        "2kr3r/ppq2ppp/2n1pn2/3p4/3P4/2PB1N2/P1Q2PPP/R4RK1 w - - 0 15",
+        "r1b2rk1/2q1bppp/p2ppn2/1p6/3BPP2/2N2B2/PPPQ2PP/2KR3R w - - 0 14",
+        "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+        "3r1rk1/1pp2ppp/p1nq1n2/4p3/2B1P3/2NP1Q1P/PPP3P1/3R1RK1 w - - 0 15",
+        "8/5pk1/6p1/p2P4/1p6/1P3PK1/P5P1/8 w - - 0 40",
+        "8/8/4k3/3r4/8/4K3/3R4/8 w - - 0 1",
+        "5k2/8/3K4/4P3/8/8/8/8 w - - 0 1",
+        "8/8/8/4k3/8/8/8/4KBN1 w - - 0 1",
+        "6k1/8/6K1/8/8/8/8/5Q2 w - - 0 1",
+    };
+    return fens;
+}
+
+long long Benchmark::run(int depth, int threads, int hashMB, std::ostream& out) {
+    const std::vector<std::string>& fens = positions();
+    std::vector<int> nodes(fens.size(), 0);
+    std::atomic<size_t> next{0};
+    threads = std::max(1, std::min<int>(threads, static_cast<int>(fens.size())));
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Each thread owns one engine and pulls the next unsearched position
+    auto worker = [&]() {
+        SearchEngine engine;
+        engine.setHashSize(hashMB);
+        engine.setQuietMode(true);
+        engine.setTimeLimit(0);
+        for (size_t i = next++; i < fens.size(); i = next++) {
+            Board board;
+            board.fromFEN(fens[i]);
+            engine.newGame();
+            nodes[i] = engine.search(board, depth).nodesSearched;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    long long total = 0;
+    for (size_t i = 0; i < fens.size(); i++) {
+        out << "Position " << (i + 1) << "/" << fens.size() << " nodes " << nodes[i]
+            << "  " << fens[i] << "\n";
+        total += nodes[i];
+    }
+    out << "===========================\n"
+        << "Depth           : " << depth << "\n"
+        << "Threads         : " << threads << "\n"
+        << "Hash (MB)       : " << hashMB << "\n"
+        << "Total time (ms) : " << ms << "\n"
+        << "Nodes searched  : " << total << "\n"
+        << "Nodes/second    : " << (ms > 0 ? total * 1000 / ms : 0) << std::endl;
+    return total;
+}
@@ -0,0 +1,23 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Fixed-depth search over a built-in position set (`chess_engine bench`).
+//
+// Every position is searched from a cleared hash table and cleared history,
+// so the total node count depends only on the search code and the depth:
+// it is the signature to compare when a change is meant to be
+// search-neutral. Threads split the positions between independent engines
+// and change only the wall-clock time, never the node count.
+class Benchmark {
+public:
+    static const std::vector<std::string>& positions();
+
+    // Prints one line per position and a summary; returns the node total.
+    static long long run(int depth, int threads, int hashMB, std::ostream& out);
+};
+
+#endif // BENCH_H
@@ -0,0 +1,116 @@
+#include "bitbase.h"
+#include "movegen.h"
+#include <algorithm>
+#include <bitset>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+namespace {
+    // Index layout: white king (6 bits), black king (6), side to move (1),
+    // pawn file a-d (2), 7 - pawn rank (3). Pawns on files e-h are mirrored
+    // by the caller, so 2 * 24 * 64 * 64 positions cover every case.
+    constexpr unsigned MAX_INDEX = 2 * 24 * 64 * 64;
+
+    std::bitset<MAX_INDEX> kpkWins;
+
+    unsigned kpkIndex(Color stm, Square bk, Square wk, Square psq) {
+        return wk | (bk << 6) | (static_cast<unsigned>(stm) << 12) |
+               (fileOf(psq) << 13) | ((6 - rankOf(psq)) << 15);
+    }
+
+    int distance(Square a, Square b) {
+        return std::max(std::abs(fileOf(a) - fileOf(b)), std::abs(rankOf(a) - rankOf(b)));
+    }
+
+    // Results are bit flags so the outcomes of all successors can be OR-ed
+    enum Result : uint8_t { INVALID = 0, UNKNOWN = 1, DRAW = 2, WIN = 4 };
+
+    struct KPKPosition {
+        Color  stm;
+        Square ksq[2], psq;
+        Result result;
+
+        KPKPosition() = default;
+
+        explicit KPKPosition(unsigned idx) {
+            ksq[0] = static_cast<Square>(idx & 0x3F);
+            ksq[1] = static_cast<Square>((idx >> 6) & 0x3F);
+            stm    = static_cast<Color>((idx >> 12) & 1);
+            psq    = makeSquare((idx >> 13) & 3, 6 - ((idx >> 15) & 7));
+            Square push = psq + 8;
+
+            // Overlapping pieces, touching kings, or white to move with the
+            // black king en prise: unreachable
+            if (distance(ksq[0], ksq[1]) <= 1 || ksq[0] == psq || ksq[1] == psq ||
+                (stm == Color::WHITE &&
+                 getBit(MoveGenerator::getPawnAttacks(psq, Color::WHITE), ksq[1])))
+                result = INVALID;
+
+            // The pawn promotes and the new queen cannot be taken
+            else if (stm == Color::WHITE && rankOf(psq) == 6 && ksq[0] != push &&
+                     (distance(ksq[1], push) > 1 || distance(ksq[0], push) == 1))
+                result = WIN;
+
+            // Stalemate, or the black king takes the undefended pawn
+            else if (stm == Color::BLACK &&
+                     (!(MoveGenerator::getKingAttacks(ksq[1]) &
+                        ~(MoveGenerator::getKingAttacks(ksq[0]) |
+                          MoveGenerator::getPawnAttacks(psq, Color::WHITE))) ||
+                      getBit(MoveGenerator::getKingAttacks(ksq[1]) &
+                             ~MoveGenerator::getKingAttacks(ksq[0]), psq)))
+                result = DRAW;
+
+            else
+                result = UNKNOWN;
+        }
+
+        // White to move wins if any move wins and draws if every move draws;
+        // black to move draws if any move draws and loses if every move loses.
+        Result classify(const std::vector<KPKPosition>& db) {
+            const Result good = (stm == Color::WHITE) ? WIN : DRAW;
+            const Result bad  = (stm == Color::WHITE) ? DRAW : WIN;
+
+            unsigned r = INVALID;
+            Bitboard b = MoveGenerator::getKingAttacks(ksq[static_cast<int>(stm)]);
+            while (b) {
+                Square to = firstSquare(b); b &= b - 1;
+                r |= (stm == Color::WHITE) ? db[kpkIndex(Color::BLACK, ksq[1], to, psq)].result
+                                           : db[kpkIndex(Color::WHITE, to, ksq[0], psq)].result;
+            }
+
+            if (stm == Color::WHITE) {
+                if (rankOf(psq) < 6)
+                    r |= db[kpkIndex(Color::BLACK, ksq[1], ksq[0], psq + 8)].result;
+                if (rankOf(psq) == 1 && psq + 8 != ksq[0] && psq + 8 != ksq[1])
+                    r |= db[kpkIndex(Color::BLACK, ksq[1], ksq[0], psq + 16)].result;
+            }
+
+            return result = (r & good) ? good : (r & UNKNOWN) ? UNKNOWN : bad;
+        }
+    };
+
+    std::once_flag kpkSolved;
+
+    void solveKPK() {
+        std::vector<KPKPosition> db(MAX_INDEX);
+        for (unsigned idx = 0; idx < MAX_INDEX; idx++) db[idx] = KPKPosition(idx);
+
+        // Propagate until nothing changes (about 15 passes)
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (unsigned idx = 0; idx < MAX_INDEX; idx++)
+                if (db[idx].result == UNKNOWN && db[idx].classify(db) != UNKNOWN)
+                    changed = true;
+        }
+
+        for (unsigned idx = 0; idx < MAX_INDEX; idx++)
+            if (db[idx].result == WIN) kpkWins.set(idx);
+    }
+}
+
+bool Bitbase::probeKPK(Square whiteKing, Square whitePawn, Square blackKing, Color sideToMove) {
+    std::call_once(kpkSolved, solveKPK);
+    return kpkWins[kpkIndex(sideToMove, blackKing, whiteKing, whitePawn)];
+}
@@ -13,6 +13,10 @@ namespace {
     uint64_t ZOB_SIDE;
     uint64_t ZOB_CASTLE[4];
     uint64_t ZOB_EP[8];
+    // Material keys: one per (piece, count before adding it). Two positions
+    // share a material key exactly when they have the same piece counts
+    // (counts past 15, only possible from a bogus FEN, wrap around).
+    uint64_t ZOB_MATERIAL[12][16];
 
     struct ZobristInit {
         ZobristInit() {
@@ -29,6 +33,8 @@ namespace {
             ZOB_SIDE = rng();
             for (auto& key : ZOB_CASTLE) key = rng();
             for (auto& key : ZOB_EP)     key = rng();
+            for (auto& countKeys : ZOB_MATERIAL)
+                for (auto& key : countKeys) key = rng();
         }
     } zobristInit;
 }
@@ -46,6 +52,7 @@ void Board::setupStartingPosition() {
 void Board::addPiece(Square sq, Piece piece) {
     int idx = getPieceIndex(piece.type, piece.color);
     Bitboard bit = 1ULL << sq;
+    materialKey ^= ZOB_MATERIAL[idx][popCount(pieceBitboards[idx]) & 15];
     pieceBitboards[idx] |= bit;
     (piece.color == Color::WHITE ? whitePieces : blackPieces) |= bit;
     allPieces |= bit;
@@ -58,12 +65,20 @@ void Board::removePiece(Square sq) {
     int idx = getPieceIndex(piece.type, piece.color);
     Bitboard bit = 1ULL << sq;
     pieceBitboards[idx] &= ~bit;
+    materialKey ^= ZOB_MATERIAL[idx][popCount(pieceBitboards[idx]) & 15];
     (piece.color == Color::WHITE ? whitePieces : blackPieces) &= ~bit;
     allPieces &= ~bit;
     squares[sq] = Piece();
     hash ^= ZOB_PIECES[idx][sq];
 }
 
+uint64_t Board::materialKeyFor(const std::array<int, 12>& counts) {
+    uint64_t key = 0;
+    for (int idx = 0; idx < 12; idx++)
+        for (int n = 0; n < counts[idx]; n++) key ^= ZOB_MATERIAL[idx][n];
+    return key;
+}
+
 uint64_t Board::castlingHash() const {
     uint64_t h = 0;
     if (canCastleKingSide[0])  h ^= ZOB_CASTLE[0];
@@ -300,12 +315,8 @@ bool Board::fromFEN(const std::string& fen) {
         return false;
     }
 
-    for (auto& bb : pieceBitboards) bb = EMPTY_BOARD;
-    squares.fill(Piece());
-    whitePieces = blackPieces = allPieces = 0;
-    hash = 0;
-
     // Piece placement: ranks are given top (rank 8) to bottom (rank 1)
+    std::array<Piece, 64> placement;
     int file = 0, rank = 7;
     for (char c : piecePlacement) {
         if (c == '/') {
@@ -325,29 +336,80 @@ bool Board::fromFEN(const std::string& fen) {
                 case 'k': type = PieceType::KING;   break;
                 default: return false;
             }
-            addPiece(makeSquare(file, rank), Piece(type, color));
+            if (file > 7 || rank < 0) return false;
+            placement[makeSquare(file, rank)] = Piece(type, color);
             file++;
         }
     }
 
-    sideToMove = (sideStr == "w") ? Color::WHITE : Color::BLACK;
+    int castling = 0;
+    if (castlingStr.find('K') != std::string::npos) castling |= 1;
+    if (castlingStr.find('Q') != std::string::npos) castling |= 2;
+    if (castlingStr.find('k') != std::string::npos) castling |= 4;
+    if (castlingStr.find('q') != std::string::npos) castling |= 8;
 
-    canCastleKingSide[0]  = castlingStr.find('K') != std::string::npos;
-    canCastleQueenSide[0] = castlingStr.find('Q') != std::string::npos;
-    canCastleKingSide[1]  = castlingStr.find('k') != std::string::npos;
-    canCastleQueenSide[1] = castlingStr.find('q') != std::string::npos;
+    Square enPassant = 64;
+    if (enPassantStr != "-") enPassant = makeSquare(enPassantStr[0] - 'a', enPassantStr[1] - '1');
 
-    if (enPassantStr == "-") {
-        enPassantSquare = 64;
-    } else {
-        enPassantSquare = makeSquare(enPassantStr[0] - 'a', enPassantStr[1] - '1');
-    }
+    setPosition(placement, sideStr == "w" ? Color::WHITE : Color::BLACK, castling,
+                enPassant, halfMove, fullMove);
+    return true;
+}
 
-    halfMoveClock  = halfMove;
-    fullMoveNumber = fullMove;
+void Board::setPosition(const std::array<Piece, 64>& placement, Color side, int castling,
+                        Square enPassant, int halfMove, int fullMove) {
+    for (auto& bb : pieceBitboards) bb = EMPTY_BOARD;
+    squares.fill(Piece());
+    whitePieces = blackPieces = allPieces = 0;
+    hash = 0;
+    materialKey = 0;
+    for (int sq = 0; sq < 64; sq++)
+        if (!placement[sq].isEmpty()) addPiece(static_cast<Square>(sq), placement[sq]);
+
+    sideToMove = side;
+    canCastleKingSide[0]  = castling & 1;
+    canCastleQueenSide[0] = castling & 2;
+    canCastleKingSide[1]  = castling & 4;
+    canCastleQueenSide[1] = castling & 8;
+    enPassantSquare = enPassant;
+    halfMoveClock   = halfMove;
+    fullMoveNumber  = fullMove;
 
     undoStack.clear();
     normalizeEnPassant();  // GUIs often send phantom ep squares in FEN
     recomputeHash();
-    return true;
+}
+
+std::string Board::toFEN() const {
+    std::string fen;
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            Piece p = squares[makeSquare(file, rank)];
+            if (p.isEmpty()) { empty++; continue; }
+            if (empty) { fen += static_cast<char>('0' + empty); empty = 0; }
+            char c = "pnbrqk"[static_cast<int>(p.type)];
+            fen += (p.color == Color::WHITE) ? static_cast<char>(std::toupper(c)) : c;
+        }
+        if (empty) fen += static_cast<char>('0' + empty);
+        if (rank > 0) fen += '/';
+    }
+
+    fen += (sideToMove == Color::WHITE) ? " w " : " b ";
+    std::string castling;
+    if (canCastleKingSide[0])  castling += 'K';
+    if (canCastleQueenSide[0]) castling += 'Q';
+    if (canCastleKingSide[1])  castling += 'k';
+    if (canCastleQueenSide[1]) castling += 'q';
+    fen += castling.empty() ? "-" : castling;
+
+    fen += ' ';
+    if (enPassantSquare < 64) {
+        fen += static_cast<char>('a' + fileOf(enPassantSquare));
+        fen += static_cast<char>('1' + rankOf(enPassantSquare));
+    } else {
+        fen += '-';
+    }
+    fen += " " + std::to_string(halfMoveClock) + " " + std::to_string(fullMoveNumber);
+    return fen;
 }
@@ -28,6 +28,7 @@ private:
     int halfMoveClock;
     int fullMoveNumber;
     uint64_t hash;               // zobrist key, kept incrementally up to date
+    uint64_t materialKey;        // depends only on piece counts, also incremental
 
     // Minimal undo record per move (also pushed for null moves)
     struct Undo {
@@ -51,6 +52,12 @@ public:
     // Game state
     Color getSideToMove() const { return sideToMove; }
     uint64_t getHash() const { return hash; }
+    uint64_t getMaterialKey() const { return materialKey; }
+    // Material key for the given piece counts, indexed like the bitboards
+    // (white pawn..king, then black pawn..king)
+    static uint64_t materialKeyFor(const std::array<int, 12>& counts);
+    int getHalfMoveClock() const { return halfMoveClock; }
+    int getFullMoveNumber() const { return fullMoveNumber; }
 
     // Castling rights
     bool canCastle(Color color, bool kingSide) const {
@@ -88,6 +95,13 @@ public:
 
     // FEN notation
     bool fromFEN(const std::string& fen);
+    std::string toFEN() const;
+
+    // Sets up a position from its parts: the piece on each square (Piece()
+    // when empty), castling rights as bits K=1 Q=2 k=4 q=8, and the en
+    // passant square (64 = none). fromFEN and packed records end up here.
+    void setPosition(const std::array<Piece, 64>& placement, Color side, int castling,
+                     Square enPassant, int halfMove, int fullMove);
 
 private:
     static int getPieceIndex(PieceType type, Color color) {
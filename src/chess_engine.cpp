@@ -0,0 +1,160 @@
+#include "chess_engine.h"
+#include "board.h"
+#include "evaluate.h"
+#include "perft.h"
+#include "pgn.h"
+#include "search.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+static_assert(CE_MATE_SCORE == MATE_SCORE, "C API mate score out of sync with the search");
+
+struct ce_engine {
+    Board board;
+    SearchEngine search;
+    std::atomic<bool> stop{false};
+};
+
+namespace {
+    const char* const STARTPOS = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    constexpr int DEFAULT_DEPTH = 12;  // same cap UCI applies to unbounded searches
+
+    void copyMove(char (&dest)[6], const Move& move) {
+        std::string uci = move.from != move.to ? moveToUci(move) : "";
+        std::snprintf(dest, sizeof dest, "%s", uci.c_str());
+    }
+}
+
+extern "C" {
+
+const char* ce_version(void) {
+    return "1.0";
+}
+
+// No C++ exception may cross into the host: the entry points that allocate
+// (hash tables, boards, strings, threads) turn a failure into an error code.
+ce_engine* ce_create(int hash_mb) {
+    ce_engine* engine = nullptr;
+    try {
+        engine = new ce_engine();
+        engine->board.fromFEN(STARTPOS);
+        engine->search.setQuietMode(true);
+        engine->search.setBookEnabled(false);
+        engine->search.setStopFlag(&engine->stop);
+        if (hash_mb > 0) engine->search.setHashSize(hash_mb);
+        return engine;
+    } catch (...) {
+        delete engine;
+        return nullptr;
+    }
+}
+
+void ce_destroy(ce_engine* engine) {
+    delete engine;
+}
+
+void ce_new_game(ce_engine* engine) {
+    if (engine) engine->search.newGame();
+}
+
+int ce_set_position(ce_engine* engine, const char* fen, const char* moves) {
+    if (!engine) return CE_INVALID_ARG;
+    try {
+        Board board;
+        if (!fen || std::strcmp(fen, "startpos") == 0) fen = STARTPOS;
+        if (!board.fromFEN(fen)) return CE_INVALID_FEN;
+
+        if (moves) {
+            std::istringstream iss(moves);
+            std::string token;
+            while (iss >> token) {
+                Move move = PgnReader::resolveMove(board, token);
+                if (move.from == move.to) return CE_ILLEGAL_MOVE;
+                board.makeMove(move);
+            }
+        }
+        engine->board = board;
+        return CE_OK;
+    } catch (...) {
+        return CE_OUT_OF_MEMORY;
+    }
+}
+
+int ce_get_fen(const ce_engine* engine, char* buf, size_t size) {
+    if (!engine) return CE_INVALID_ARG;
+    try {
+        std::string fen = engine->board.toFEN();
+        if (buf && size > fen.size()) std::memcpy(buf, fen.c_str(), fen.size() + 1);
+        return static_cast<int>(fen.size());
+    } catch (...) {
+        return CE_OUT_OF_MEMORY;
+    }
+}
+
+int ce_search(ce_engine* engine, const ce_limits* limits,
+              ce_info_callback callback, void* user_data,
+              ce_search_result* result) {
+    if (!engine || !result) return CE_INVALID_ARG;
+    ce_limits none = {0, 0, 0};
+    if (!limits) limits = &none;
+
+    try {
+        int depth = limits->depth;
+        if (depth <= 0) depth = (limits->movetime_ms > 0 || limits->nodes > 0) ? 64 : DEFAULT_DEPTH;
+
+        engine->stop = false;
+        engine->search.setTimeLimit(limits->movetime_ms > 0 ? limits->movetime_ms : 0);
+        engine->search.setSoftTimeLimit(limits->movetime_ms > 0 ? limits->movetime_ms : 0);
+        engine->search.setNodeLimit(limits->nodes > 0 ? limits->nodes : 0);
+        if (callback) {
+            engine->search.setInfoCallback([callback, user_data](const SearchInfo& info) {
+                ce_search_info out;
+                out.depth   = info.depth;
+                out.score   = info.score;
+                out.nodes   = info.nodes;
+                out.time_ms = info.timeMs;
+                copyMove(out.best_move, info.bestMove);
+                callback(&out, user_data);
+            });
+        } else {
+            engine->search.setInfoCallback(nullptr);
+        }
+
+        SearchResult r = engine->search.search(engine->board, depth);
+        engine->search.setInfoCallback(nullptr);
+
+        copyMove(result->best_move, r.bestMove);
+        result->score   = r.score;
+        result->depth   = r.depth;
+        result->nodes   = r.nodesSearched;
+        result->tb_hits = r.tbHits;
+        return CE_OK;
+    } catch (...) {
+        engine->search.setInfoCallback(nullptr);
+        return CE_OUT_OF_MEMORY;
+    }
+}
+
+void ce_stop(ce_engine* engine) {
+    if (engine) engine->stop = true;
+}
+
+int ce_evaluate(const ce_engine* engine) {
+    if (!engine) return 0;
+    int score = Evaluation::evaluate(engine->board);
+    return engine->board.getSideToMove() == Color::WHITE ? score : -score;
+}
+
+unsigned long long ce_perft(const ce_engine* engine, int depth, int threads) {
+    if (!engine || depth < 0) return 0;
+    try {
+        return Perft::count(engine->board, depth, threads > 0 ? threads : 1);
+    } catch (...) {
+        return 0;
+    }
+}
+
+} // extern "C"
@@ -0,0 +1,110 @@
+#ifndef CHESS_ENGINE_H
+#define CHESS_ENGINE_H
+
+/*
+ * C API of libchess_engine, for hosts that want the engine in-process
+ * rather than over UCI pipes (ctypes, cffi, other languages' FFIs).
+ *
+ * Every handle owns its own position, transposition table and search
+ * state, so a host can run any number of them at once, one thread per
+ * handle. A single handle is not thread-safe, except for ce_stop(), which
+ * may be called from any thread while ce_search() runs.
+ *
+ * Scores are centipawns from the side to move's point of view, as in UCI
+ * "info score cp"; mates are reported as +/-(CE_MATE_SCORE - plies).
+ * Moves are coordinate strings ("e2e4", "e7e8q").
+ */
+
+#include <stddef.h>
+
+/* CHESS_ENGINE_STATIC: linking the static library (set by its CMake target) */
+#if defined(CHESS_ENGINE_STATIC)
+#  define CE_API
+#elif defined(_WIN32)
+#  if defined(CHESS_ENGINE_BUILD)
+#    define CE_API __declspec(dllexport)
+#  else
+#    define CE_API __declspec(dllimport)
+#  endif
+#else
+#  define CE_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CE_MATE_SCORE 10000
+
+/* Return codes */
+#define CE_OK             0
+#define CE_INVALID_FEN   -1
+#define CE_ILLEGAL_MOVE  -2
+#define CE_INVALID_ARG   -3
+#define CE_OUT_OF_MEMORY -4
+
+typedef struct ce_engine ce_engine;
+
+/* Limits for ce_search(); zero means no limit of that kind. With every
+ * limit zero the search stops at depth 12. */
+typedef struct {
+    int depth;
+    int movetime_ms;
+    int nodes;
+} ce_limits;
+
+/* Progress after each completed iteration */
+typedef struct {
+    int depth;
+    int score;
+    long long nodes;
+    long long time_ms;
+    char best_move[6];
+} ce_search_info;
+
+typedef struct {
+    char best_move[6];   /* empty when the position has no legal move */
+    int score;
+    int depth;
+    long long nodes;
+    int tb_hits;
+} ce_search_result;
+
+typedef void (*ce_info_callback)(const ce_search_info* info, void* user_data);
+
+CE_API const char* ce_version(void);
+
+/* hash_mb <= 0 selects the default table size. NULL on allocation failure. */
+CE_API ce_engine* ce_create(int hash_mb);
+CE_API void ce_destroy(ce_engine* engine);
+
+/* Clears the hash table and move-ordering history (ucinewgame) */
+CE_API void ce_new_game(ce_engine* engine);
+
+/* fen NULL or "startpos" = starting position; moves is an optional space-
+ * separated list of coordinate moves played from it. On error the handle
+ * keeps its previous position. */
+CE_API int ce_set_position(ce_engine* engine, const char* fen, const char* moves);
+/* Writes the current position's FEN; returns its length, or the size
+ * needed (excluding the terminator) if buf is too small, or an error code. */
+CE_API int ce_get_fen(const ce_engine* engine, char* buf, size_t size);
+
+/* Blocking. callback may be NULL; it runs on the calling thread. */
+CE_API int ce_search(ce_engine* engine, const ce_limits* limits,
+                     ce_info_callback callback, void* user_data,
+                     ce_search_result* result);
+/* Makes a running ce_search() on this handle return as soon as possible */
+CE_API void ce_stop(ce_engine* engine);
+
+/* Static evaluation of the current position */
+CE_API int ce_evaluate(const ce_engine* engine);
+
+/* Leaf count of the legal move tree to depth; threads <= 0 uses one.
+ * 0 if the worker threads cannot be started. */
+CE_API unsigned long long ce_perft(const ce_engine* engine, int depth, int threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHESS_ENGINE_H */
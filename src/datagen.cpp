@@ -0,0 +1,132 @@
+#include "datagen.h"
+#include "board.h"
+#include "movegen.h"
+#include "packed_position.h"
+#include "search.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr int MAX_DEPTH = 64;  // the node limit always ends the search first
+
+    // Plays one game; fills positions and returns the result from white's
+    // side, or false if the random opening ran into the end of the game.
+    bool playGame(SearchEngine& engine, std::mt19937_64& rng, const DataGenerator::Options& o,
+                  std::vector<PackedPosition>& positions, int& result) {
+        positions.clear();
+        Board board;
+        board.setupStartingPosition();
+        engine.newGame();
+
+        MoveList legal;
+        for (int i = 0; i < o.randomPlies; i++) {
+            MoveGenerator::generateLegalMoves(board, legal);
+            if (legal.empty()) return false;
+            board.makeMove(legal[rng() % legal.size()]);
+        }
+
+        std::vector<int> scores;  // white-relative, one per recorded position
+        int winStreak = 0, lastSign = 0;
+        for (int ply = 0;; ply++) {
+            MoveGenerator::generateLegalMoves(board, legal);
+            Color stm = board.getSideToMove();
+            bool inCheck = board.isInCheck(stm);
+            if (legal.empty()) {
+                result = !inCheck ? 0 : (stm == Color::WHITE ? -1 : 1);
+                break;
+            }
+            if (board.isDrawByFiftyMoves() || board.isRepetition() ||
+                board.isInsufficientMaterial() || ply >= o.maxPlies) {
+                result = 0;
+                break;
+            }
+
+            SearchResult r = engine.search(board, MAX_DEPTH);
+            int score = (stm == Color::WHITE) ? r.score : -r.score;
+
+            // Both sides agreeing on a decisive score ends the game early
+            int sign = std::abs(score) >= o.winScore ? (score > 0 ? 1 : -1) : 0;
+            winStreak = (sign && sign == lastSign) ? winStreak + 1 : (sign ? 1 : 0);
+            lastSign = sign;
+            if (winStreak >= o.winPlies) {
+                result = sign;
+                break;
+            }
+
+            const Move& best = r.bestMove;
+            bool quiet = !best.isCapture && best.promotion == PieceType::NONE;
+            // With one legal move the engine does not search, so no score
+            if (!inCheck && quiet && legal.size() > 1 && std::abs(r.score) < TB_WIN_SCORE)
+                positions.push_back(PackedPosition::pack(board, score, 0));
+
+            board.makeMove(best);
+        }
+
+        for (PackedPosition& p : positions) p.result = static_cast<int8_t>(result);
+        return true;
+    }
+}
+
+long long DataGenerator::run(const Options& options, std::ostream& log) {
+    std::FILE* file = std::fopen(options.path.c_str(), "ab");
+    if (!file) return -1;
+    // Records go out a megabyte at a time
+    std::vector<char> buffer(1 << 20);
+    std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+    int threads = options.threads > 0 ? options.threads
+                                      : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    threads = std::max(1, std::min(threads, options.games));
+    uint64_t seed = options.seed ? options.seed
+                                 : static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+
+    std::mutex mutex;
+    std::atomic<int> nextGame{0};
+    long long written = 0;
+    int finished = 0, results[3] = {0, 0, 0};
+    auto start = std::chrono::steady_clock::now();
+
+    log << "datagen: " << options.games << " games, " << options.nodes << " nodes per move, "
+        << threads << " threads, writing " << options.path << std::endl;
+
+    auto worker = [&](int index) {
+        SearchEngine engine;
+        engine.setHashSize(options.hashMB);
+        engine.setQuietMode(true);
+        engine.setTimeLimit(0);
+        engine.setNodeLimit(options.nodes);
+        std::mt19937_64 rng(seed + 0x9E3779B97F4A7C15ULL * (index + 1));
+        std::vector<PackedPosition> positions;
+
+        while (nextGame++ < options.games) {
+            int result = 0;
+            while (!playGame(engine, rng, options, positions, result)) {}
+
+            std::lock_guard<std::mutex> lock(mutex);
+            std::fwrite(positions.data(), sizeof(PackedPosition), positions.size(), file);
+            written += static_cast<long long>(positions.size());
+            results[result + 1]++;
+            if (++finished % 100 == 0 || finished == options.games) {
+                double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                log << "games " << finished << "  positions " << written
+                    << "  (+" << results[2] << " =" << results[1] << " -" << results[0] << ")  "
+                    << static_cast<long long>(secs > 0 ? written / secs : 0) << " pos/s" << std::endl;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker, t);
+    worker(0);
+    for (std::thread& t : pool) t.join();
+
+    std::fclose(file);
+    return written;
+}
@@ -0,0 +1,37 @@
+#ifndef DATAGEN_H
+#define DATAGEN_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Self-play training data (`chess_engine datagen`).
+//
+// Every thread plays its own games with a SearchEngine limited to a fixed
+// number of nodes per move, starting from a few random moves so no two
+// games are alike. Positions are kept with the search score and, once the
+// game is over, its result, and written to one file as PackedPosition
+// records. The random opening, positions in check and positions whose best
+// move is a capture or promotion are left out: they say little about the
+// static evaluation of a quiet position.
+class DataGenerator {
+public:
+    struct Options {
+        std::string path = "data.bin";  // appended to
+        int games       = 1000;
+        int nodes       = 5000;         // per move
+        int threads     = 0;            // 0 = all hardware threads
+        int randomPlies = 8;            // opening moves played at random
+        int hashMB      = 16;           // per thread
+        int maxPlies    = 400;          // then the game is a draw
+        int winScore    = 1000;         // adjudicated once both sides see this
+        int winPlies    = 8;            //   for this many plies in a row
+        uint64_t seed   = 0;            // 0 = from the clock
+    };
+
+    // Logs progress to log; returns the number of positions written, or -1
+    // if the output file cannot be opened.
+    static long long run(const Options& options, std::ostream& log);
+};
+
+#endif // DATAGEN_H
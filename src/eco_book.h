@@ -2,11 +2,26 @@
 #define ECO_BOOK_H
 
 #include <cstddef>
+#include <cstdint>
 
-// ECO opening book (contents of eco.pgn) embedded at build time so the
-// engine works as a single self-contained executable.
-// Regenerate eco_book.cpp with scripts/embed_book.py after editing eco.pgn.
-extern const unsigned char ECO_BOOK_DATA[];
-extern const std::size_t ECO_BOOK_SIZE;
+// One book move: the move packed as from | to << 6 | promotion << 12
+// (promotion 0 = none, else the PieceType), and how many book lines
+// continue through it.
+struct BookMove {
+    uint32_t weight;
+    uint16_t move;
+};
+
+// ECO opening book (eco.pgn) compiled into the binary in the same flat
+// layout OpeningBook builds for a loaded book: position keys (zobrist
+// hashes) in ascending order, and for position i its moves at
+// ECO_BOOK_MOVES[ECO_BOOK_OFFSETS[i]] up to ECO_BOOK_MOVES[ECO_BOOK_OFFSETS[i + 1]],
+// heaviest first. A lookup searches the tables in place, with nothing to
+// parse or allocate at startup. Regenerate eco_book.cpp with
+// scripts/embed_book.py after editing eco.pgn.
+extern const uint64_t ECO_BOOK_KEYS[];
+extern const uint32_t ECO_BOOK_OFFSETS[];   // ECO_BOOK_POSITIONS + 1 entries
+extern const BookMove ECO_BOOK_MOVES[];
+extern const std::size_t ECO_BOOK_POSITIONS;
 
 #endif // ECO_BOOK_H
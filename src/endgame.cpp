@@ -0,0 +1,246 @@
+#include "endgame.h"
+#include "bitbase.h"
+#include "movegen.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+
+namespace {
+    // Endgame material values, as Evaluation::pieceValueEG
+    constexpr int PAWN_EG = 115, KNIGHT_EG = 300, BISHOP_EG = 345, ROOK_EG = 520, QUEEN_EG = 1000;
+
+    // A certain win: above any ordinary advantage, far below mate scores
+    constexpr int KNOWN_WIN = 600;
+
+    int distance(Square a, Square b) {
+        return std::max(std::abs(fileOf(a) - fileOf(b)), std::abs(rankOf(a) - rankOf(b)));
+    }
+
+    // 0 in the centre, 120 in a corner
+    int pushToEdge(Square sq) {
+        int f = fileOf(sq), r = rankOf(sq);
+        return 20 * (std::max(3 - std::min(f, 7 - f), 0) + std::max(3 - std::min(r, 7 - r), 0));
+    }
+
+    // 120 for touching kings, less the further apart they are
+    int pushClose(Square a, Square b) { return 140 - 20 * distance(a, b); }
+
+    Bitboard pieces(const Board& board, PieceType type, Color color) {
+        return board.getPieceBitboard(type, color);
+    }
+
+    // ---------------------------------------------------------------------
+    // Evaluation functions: score for the strong side
+    // ---------------------------------------------------------------------
+
+    // Mating material against a bare king: drive it to the edge and walk
+    // our own king up to help.
+    int evaluateKXK(const Board& board, Color strong) {
+        Square sk = board.findKing(strong), wk = board.findKing(~strong);
+        int score = PAWN_EG   * popCount(pieces(board, PieceType::PAWN,   strong)) +
+                    KNIGHT_EG * popCount(pieces(board, PieceType::KNIGHT, strong)) +
+                    BISHOP_EG * popCount(pieces(board, PieceType::BISHOP, strong)) +
+                    ROOK_EG   * popCount(pieces(board, PieceType::ROOK,   strong)) +
+                    QUEEN_EG  * popCount(pieces(board, PieceType::QUEEN,  strong));
+        score += pushToEdge(wk) + pushClose(sk, wk);
+
+        constexpr Bitboard DARK = 0xAA55AA55AA55AA55ULL;
+        Bitboard bishops = pieces(board, PieceType::BISHOP, strong);
+        if (pieces(board, PieceType::QUEEN, strong) || pieces(board, PieceType::ROOK, strong) ||
+            (pieces(board, PieceType::KNIGHT, strong) && bishops) ||
+            ((bishops & DARK) && (bishops & ~DARK)))
+            score += KNOWN_WIN;
+        return score;
+    }
+
+    // Bishop and knight mate only works in a corner of the bishop's colour;
+    // the general mop-up pushes towards any corner and often gets stuck.
+    int evaluateKBNK(const Board& board, Color strong) {
+        Square sk = board.findKing(strong), wk = board.findKing(~strong);
+        Square bishop = firstSquare(pieces(board, PieceType::BISHOP, strong));
+        bool darkBishop = (fileOf(bishop) + rankOf(bishop)) % 2 == 0;  // a1 is dark
+        int cornerDist = darkBishop ? std::min(distance(wk, A1), distance(wk, H8))
+                                    : std::min(distance(wk, A8), distance(wk, H1));
+        return KNOWN_WIN + KNIGHT_EG + BISHOP_EG + pushToEdge(wk) +
+               40 * (7 - cornerDist) + pushClose(sk, wk);
+    }
+
+    // Queen against rook is a win, but only by pushing the king to the edge
+    // and splitting it from the rook.
+    int evaluateKQKR(const Board& board, Color strong) {
+        Square sk = board.findKing(strong), wk = board.findKing(~strong);
+        return QUEEN_EG - ROOK_EG + pushToEdge(wk) + pushClose(sk, wk);
+    }
+
+    // Rook against minor piece is usually a draw; keep a small edge so the
+    // rook side still presses.
+    int evaluateKRKB(const Board& board, Color strong) {
+        return pushToEdge(board.findKing(~strong)) / 2;
+    }
+
+    int evaluateKRKN(const Board& board, Color strong) {
+        Square wk = board.findKing(~strong);
+        Square knight = firstSquare(pieces(board, PieceType::KNIGHT, ~strong));
+        return pushToEdge(wk) / 2 + 10 * distance(wk, knight);
+    }
+
+    // Two knights cannot force mate
+    int evaluateKNNK(const Board&, Color) { return 0; }
+
+    // King and pawn versus king is solved exactly by the bitbase. A win
+    // climbs as the pawn advances so the search always has a way to make
+    // progress, and stays below a new queen.
+    int evaluateKPK(const Board& board, Color strong) {
+        Square psq = firstSquare(pieces(board, PieceType::PAWN, strong));
+        Square sk = board.findKing(strong);
+        Square wk = board.findKing(~strong);
+        Color stm = board.getSideToMove();
+
+        // Normalize: pawn side is white, pawn on files a-d
+        if (strong == Color::BLACK) {
+            sk ^= 56; wk ^= 56; psq ^= 56;
+            stm = ~stm;
+        }
+        if (fileOf(psq) > 3) { sk ^= 7; wk ^= 7; psq ^= 7; }
+
+        if (!Bitbase::probeKPK(sk, psq, wk, stm)) return 0;
+        return KNOWN_WIN + 40 * rankOf(psq);
+    }
+
+    // ---------------------------------------------------------------------
+    // Scaling functions: factor out of SCALE_NORMAL for the strong side
+    // ---------------------------------------------------------------------
+
+    // Rook pawn with a bishop that does not control the promotion square:
+    // a draw once the defending king reaches the corner.
+    int scaleKBPK(const Board& board, Color strong) {
+        Square psq = firstSquare(pieces(board, PieceType::PAWN, strong));
+        if (fileOf(psq) != 0 && fileOf(psq) != 7) return Endgames::SCALE_NORMAL;
+
+        Square queening = makeSquare(fileOf(psq), strong == Color::WHITE ? 7 : 0);
+        Square bishop = firstSquare(pieces(board, PieceType::BISHOP, strong));
+        bool sameColour = ((fileOf(bishop) + rankOf(bishop)) % 2) ==
+                          ((fileOf(queening) + rankOf(queening)) % 2);
+        if (!sameColour && distance(board.findKing(~strong), queening) <= 1)
+            return Endgames::SCALE_DRAW;
+        return Endgames::SCALE_NORMAL;
+    }
+
+    // ---------------------------------------------------------------------
+    // Registry
+    // ---------------------------------------------------------------------
+
+    using EvalFn  = int (*)(const Board&, Color);
+    using ScaleFn = int (*)(const Board&, Color);
+
+    template <typename Fn>
+    struct Entry {
+        Fn fn;
+        Color strong;
+    };
+
+    class Registry {
+    public:
+        Registry() {
+            addEval("KBNK", evaluateKBNK);
+            addEval("KQKR", evaluateKQKR);
+            addEval("KRKB", evaluateKRKB);
+            addEval("KRKN", evaluateKRKN);
+            addEval("KNNK", evaluateKNNK);
+            addEval("KPK",  evaluateKPK);
+
+            addScale("KBPK", scaleKBPK);
+        }
+
+        const Entry<EvalFn>* findEval(uint64_t key) const {
+            auto it = evals.find(key);
+            return it == evals.end() ? nullptr : &it->second;
+        }
+
+        const Entry<ScaleFn>* findScale(uint64_t key) const {
+            auto it = scales.find(key);
+            return it == scales.end() ? nullptr : &it->second;
+        }
+
+        int maxPieces = 0;  // nothing with more pieces is registered
+
+    private:
+        std::unordered_map<uint64_t, Entry<EvalFn>>  evals;
+        std::unordered_map<uint64_t, Entry<ScaleFn>> scales;
+
+        // code lists the strong side's pieces then the weak side's, each
+        // starting with its king: "KBNK", "KQKR"
+        static uint64_t keyFor(const std::string& code, Color strong) {
+            std::array<int, 12> counts{};
+            int side = (strong == Color::WHITE) ? 0 : 6;
+            for (size_t i = 0; i < code.size(); i++) {
+                if (i > 0 && code[i] == 'K') side = 6 - side;
+                int type = static_cast<int>(std::string("PNBRQK").find(code[i]));
+                counts[side + type]++;
+            }
+            return Board::materialKeyFor(counts);
+        }
+
+        template <typename Fn>
+        void add(std::unordered_map<uint64_t, Entry<Fn>>& map, const std::string& code, Fn fn) {
+            map[keyFor(code, Color::WHITE)] = {fn, Color::WHITE};
+            map[keyFor(code, Color::BLACK)] = {fn, Color::BLACK};
+            maxPieces = std::max(maxPieces, static_cast<int>(code.size()));
+        }
+
+        void addEval(const std::string& code, EvalFn fn)   { add(evals, code, fn); }
+        void addScale(const std::string& code, ScaleFn fn) { add(scales, code, fn); }
+    };
+
+    // Built on first use: the keys come from board.cpp's material zobrist
+    // table, which must be initialized first.
+    const Registry& registry() {
+        static const Registry instance;
+        return instance;
+    }
+
+    int nonPawnMaterial(const Board& board, Color color) {
+        return KNIGHT_EG * popCount(pieces(board, PieceType::KNIGHT, color)) +
+               BISHOP_EG * popCount(pieces(board, PieceType::BISHOP, color)) +
+               ROOK_EG   * popCount(pieces(board, PieceType::ROOK,   color)) +
+               QUEEN_EG  * popCount(pieces(board, PieceType::QUEEN,  color));
+    }
+}
+
+bool Endgames::evaluate(const Board& board, int& score) {
+    const Registry& reg = registry();
+
+    if (popCount(board.getAllPieces()) <= reg.maxPieces) {
+        if (const Entry<EvalFn>* e = reg.findEval(board.getMaterialKey())) {
+            int s = e->fn(board, e->strong);
+            score = (e->strong == Color::WHITE) ? s : -s;
+            return true;
+        }
+    }
+
+    // Lone king against enough material to mate, in any combination
+    for (Color strong : {Color::WHITE, Color::BLACK}) {
+        Bitboard weakPieces = (strong == Color::WHITE) ? board.getBlackPieces() : board.getWhitePieces();
+        if (popCount(weakPieces) == 1 && nonPawnMaterial(board, strong) >= ROOK_EG) {
+            int s = evaluateKXK(board, strong);
+            score = (strong == Color::WHITE) ? s : -s;
+            return true;
+        }
+    }
+    return false;
+}
+
+int Endgames::scaleFactor(const Board& board, Color strongSide) {
+    // A lone minor piece without pawns cannot win
+    if (!pieces(board, PieceType::PAWN, strongSide) && nonPawnMaterial(board, strongSide) <= BISHOP_EG)
+        return SCALE_DRAW;
+
+    const Registry& reg = registry();
+    if (popCount(board.getAllPieces()) <= reg.maxPieces) {
+        const Entry<ScaleFn>* e = reg.findScale(board.getMaterialKey());
+        if (e && e->strong == strongSide) return e->fn(board, strongSide);
+    }
+    return SCALE_NORMAL;
+}
@@ -0,0 +1,28 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include "types.h"
+#include "board.h"
+
+// Specialized knowledge for endgames the general evaluation gets wrong or
+// handles slowly, looked up by the board's material key.
+//
+// Evaluation functions replace the general evaluation outright (KPK, KBNK,
+// KQKR, a lone king against mating material, ...). Scaling functions keep
+// the general evaluation but shrink its endgame half when the material
+// says the stronger side cannot realistically win (wrong rook pawn, ...).
+class Endgames {
+public:
+    static constexpr int SCALE_NORMAL = 64;
+    static constexpr int SCALE_DRAW   = 0;
+
+    // True if a specialized evaluation exists for this position; score is
+    // then set, white-relative like SearchEngine::evaluate.
+    static bool evaluate(const Board& board, int& score);
+
+    // Factor out of SCALE_NORMAL to apply to the endgame score when
+    // strongSide is the one ahead in it.
+    static int scaleFactor(const Board& board, Color strongSide);
+};
+
+#endif // ENDGAME_H
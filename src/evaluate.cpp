@@ -0,0 +1,749 @@
+#include "evaluate.h"
+#include "endgame.h"
+#include "movegen.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+    // File mask: all squares on a given file
+    constexpr Bitboard fileBB(int file) { return 0x0101010101010101ULL << file; }
+
+    // All squares strictly above rank r
+    constexpr Bitboard ranksAbove(int r) {
+        return (r < 7) ? ~((1ULL << ((r + 1) * 8)) - 1) : 0ULL;
+    }
+
+    // All squares strictly below rank r
+    constexpr Bitboard ranksBelow(int r) {
+        return (r > 0) ? ((1ULL << (r * 8)) - 1) : 0ULL;
+    }
+
+    // Every square attacked by a pawn of the given colour.
+    Bitboard pawnCover(const Board& board, Color c) {
+        Bitboard bb = board.getPieceBitboard(PieceType::PAWN, c), out = 0;
+        while (bb) {
+            Square s = firstSquare(bb); bb &= bb - 1;
+            out |= MoveGenerator::getPawnAttacks(s, c);
+        }
+        return out;
+    }
+
+    // An unfinished king-safety rework, kept switched off but left in place
+    // because the measurements below are worth not repeating.
+    //   KS_NEW_TERMS - pawn attackers, pawn storm, defenders, open lines
+    //   KS_NEW_RAMP  - attacker count amplifies danger instead of discounting it
+    //
+    // Both on scored 26% over 63 games vs the build without them (~-180 Elo):
+    // the two multiply, so inflated units meet an amplified ramp and a single
+    // position can swing ~960cp, which is more than a queen. Each half alone
+    // came out level with the baseline over 60 games, so neither is bad by
+    // itself - the product is. The way forward is both on with
+    // kingDangerScale somewhere near 25-35, not either half in isolation;
+    // tools/tune can fit the scale and ramp together instead of by matches.
+    //
+    // Caveat on all of the above: 60-game matches at 60+0.6 only resolve
+    // effects around +/-100 Elo. A control that was eval-identical to the
+    // baseline and 11% faster measured -17 Elo over the same 60 games, so
+    // the two "level" readings mean "not a disaster", nothing finer.
+    constexpr bool KS_NEW_TERMS = false;
+    constexpr bool KS_NEW_RAMP  = false;
+
+    // The terms are computed as feature counts, which evaluate() weighs
+    // with the current params and trace() records as coefficients, so the
+    // two cannot drift apart.
+
+    struct KingZone {
+        Square   sq   = 64;
+        Bitboard zone = 0ULL;
+        int attackers = 0;     // distinct enemy pieces bearing on the zone
+        int hits[4]   = {};    // attacked zone squares, by knight..queen
+        int pawnHits  = 0;     // KS_NEW_TERMS from here on
+        int defenderHits = 0;  // friendly cover of the same squares
+        int storm[8]  = {};    // enemy pawns, by rank distance
+        int stormers  = 0;
+        int openOnFile = 0, openBeside = 0;
+    };
+
+    struct Activity {
+        int mobility[2][4] = {};   // safe squares, by colour and knight..queen
+        KingZone kz[2];            // by the colour of the king
+    };
+
+    // Enemy pawns marching at the king. The pawn shield only looks at our own
+    // pawns, so a storm that has not arrived yet is otherwise invisible - and
+    // by the time it arrives the lines are already open. Two files either
+    // side, because a king on c1 is very much a target for an a-file storm.
+    void pawnStorm(const Board& board, Color us, KingZone& kz) {
+        Bitboard pawns = board.getPieceBitboard(PieceType::PAWN, ~us);
+        int kf = fileOf(kz.sq), kr = rankOf(kz.sq);
+        while (pawns) {
+            Square s = firstSquare(pawns); pawns &= pawns - 1;
+            if (std::abs(fileOf(s) - kf) > 2) continue;
+            int d = std::abs(rankOf(s) - kr);
+            kz.storm[d]++;
+            if (d <= 3) kz.stormers++;
+        }
+    }
+
+    // A heavy piece on a line into the king with none of our pawns left on
+    // it. This is what the storm is trying to create.
+    void openLinesToKing(const Board& board, Color us, KingZone& kz) {
+        Bitboard ourPawns = board.getPieceBitboard(PieceType::PAWN, us);
+        Bitboard heavy = board.getPieceBitboard(PieceType::ROOK,  ~us)
+                       | board.getPieceBitboard(PieceType::QUEEN, ~us);
+        int kf = fileOf(kz.sq);
+        for (int f = std::max(0, kf - 2); f <= std::min(7, kf + 2); f++) {
+            Bitboard fb = fileBB(f);
+            if (ourPawns & fb) continue;              // still sheltered
+            if (heavy & fb) (f == kf ? kz.openOnFile : kz.openBeside)++;
+        }
+    }
+
+    // Mobility counts squares a piece could actually move to; squares
+    // covered by an enemy pawn are excluded, since a piece cannot usefully
+    // sit where a pawn just takes it.
+    //
+    // King safety needs exactly the same per-piece attack sets, and those
+    // sets are the most expensive thing in the whole evaluation, so the two
+    // terms share one loop: every attack bitboard is computed once and then
+    // asked three questions - where can this piece go, does it bear on the
+    // enemy king, does it cover our own.
+    void countActivity(const Board& board, Activity& a) {
+        Bitboard occ = board.getAllPieces();
+        KingZone* kz = a.kz;
+        for (int i = 0; i < 2; i++) {
+            kz[i].sq = board.findKing(static_cast<Color>(i));
+            if (kz[i].sq < 64)
+                kz[i].zone = MoveGenerator::getKingAttacks(kz[i].sq) | (1ULL << kz[i].sq);
+        }
+
+        for (int i = 0; i < 2; i++) {
+            Color c = static_cast<Color>(i);
+            Bitboard own = (c == Color::WHITE) ? board.getWhitePieces()
+                                               : board.getBlackPieces();
+            Bitboard bad = own | pawnCover(board, ~c);
+            KingZone& them = kz[1 - i];   // the king these pieces attack
+            KingZone& ours = kz[i];       // the king these pieces defend
+
+            auto tally = [&](PieceType t, int idx, auto attackFn) {
+                Bitboard bb = board.getPieceBitboard(t, c);
+                int mobility = 0, attackers = 0, hits = 0;
+                while (bb) {
+                    Square s = firstSquare(bb); bb &= bb - 1;
+                    Bitboard att = attackFn(s);   // the expensive part, done once
+                    mobility += popCount(att & ~bad);
+                    int n = popCount(att & them.zone);
+                    attackers += n != 0;
+                    hits += n;
+                    if (KS_NEW_TERMS)
+                        ours.defenderHits += popCount(att & ours.zone);
+                }
+                a.mobility[i][idx] = mobility;
+                them.attackers += attackers;
+                them.hits[idx] = hits;
+            };
+
+            tally(PieceType::KNIGHT, 0, [&](Square s){ return MoveGenerator::getKnightAttacks(s); });
+            tally(PieceType::BISHOP, 1, [&](Square s){ return MoveGenerator::getBishopAttacks(s, occ); });
+            tally(PieceType::ROOK,   2, [&](Square s){ return MoveGenerator::getRookAttacks(s, occ); });
+            tally(PieceType::QUEEN,  3, [&](Square s){ return MoveGenerator::getQueenAttacks(s, occ); });
+
+            // Pawns bear on the zone too - a pawn on a3 beside a king on b2
+            // is as dangerous as a piece - but they carry no mobility term.
+            // The whole pawn contribution counts as a single attacker.
+            if (KS_NEW_TERMS) {
+                Bitboard pawns = board.getPieceBitboard(PieceType::PAWN, c);
+                while (pawns) {
+                    Square s = firstSquare(pawns); pawns &= pawns - 1;
+                    them.pawnHits += popCount(MoveGenerator::getPawnAttacks(s, c) & them.zone);
+                }
+                if (them.pawnHits) them.attackers++;
+            }
+        }
+
+        if (KS_NEW_TERMS) {
+            for (int i = 0; i < 2; i++) {
+                if (kz[i].sq >= 64) continue;
+                pawnStorm(board, static_cast<Color>(i), kz[i]);
+                openLinesToKing(board, static_cast<Color>(i), kz[i]);
+            }
+        }
+    }
+
+    // Which ramp entry scales a king's danger
+    int rampSlot(const KingZone& kz) {
+        return std::min(kz.attackers + (kz.stormers ? 1 : 0), 7);
+    }
+
+    struct RookFiles {
+        int semiOpen[2] = {}, open[2] = {};
+    };
+
+    RookFiles countRookFiles(const Board& board) {
+        RookFiles r;
+        Bitboard wp = board.getPieceBitboard(PieceType::PAWN, Color::WHITE);
+        Bitboard bp = board.getPieceBitboard(PieceType::PAWN, Color::BLACK);
+        for (int i = 0; i < 2; i++) {
+            Color c = static_cast<Color>(i);
+            Bitboard ownPawns   = (c == Color::WHITE) ? wp : bp;
+            Bitboard enemyPawns = (c == Color::WHITE) ? bp : wp;
+            Bitboard rooks = board.getPieceBitboard(PieceType::ROOK, c);
+            while (rooks) {
+                Square s = firstSquare(rooks); rooks &= rooks - 1;
+                Bitboard f = fileBB(fileOf(s));
+                if (ownPawns & f) continue;
+                if (enemyPawns & f) r.semiOpen[i]++;
+                else                r.open[i]++;
+            }
+        }
+        return r;
+    }
+
+    struct PawnFeatures {
+        int doubled[2] = {}, isolated[2] = {};
+        int passed[2][8] = {};   // by rank from the pawn's own side
+    };
+
+    PawnFeatures countPawns(const Board& board) {
+        PawnFeatures p;
+        Bitboard wp = board.getPieceBitboard(PieceType::PAWN, Color::WHITE);
+        Bitboard bp = board.getPieceBitboard(PieceType::PAWN, Color::BLACK);
+
+        for (int file = 0; file < 8; file++) {
+            Bitboard fb = fileBB(file);
+            int wc = popCount(wp & fb);
+            int bc = popCount(bp & fb);
+
+            // Doubled pawns
+            if (wc > 1) p.doubled[0] += wc - 1;
+            if (bc > 1) p.doubled[1] += bc - 1;
+
+            // Isolated pawns (no friendly pawn on adjacent files)
+            Bitboard adj = 0;
+            if (file > 0) adj |= fileBB(file - 1);
+            if (file < 7) adj |= fileBB(file + 1);
+
+            if (wc > 0 && !(wp & adj)) p.isolated[0] += wc;
+            if (bc > 0 && !(bp & adj)) p.isolated[1] += bc;
+        }
+
+        // Passed pawns
+        Bitboard w = wp;
+        while (w) {
+            Square sq = firstSquare(w); w &= w - 1;
+            int f = fileOf(sq), r = rankOf(sq);
+            Bitboard adjFiles = fileBB(f);
+            if (f > 0) adjFiles |= fileBB(f - 1);
+            if (f < 7) adjFiles |= fileBB(f + 1);
+            if (!(bp & adjFiles & ranksAbove(r))) p.passed[0][r]++;
+        }
+
+        Bitboard b = bp;
+        while (b) {
+            Square sq = firstSquare(b); b &= b - 1;
+            int f = fileOf(sq), r = rankOf(sq);
+            Bitboard adjFiles = fileBB(f);
+            if (f > 0) adjFiles |= fileBB(f - 1);
+            if (f < 7) adjFiles |= fileBB(f + 1);
+            if (!(wp & adjFiles & ranksBelow(r))) p.passed[1][7 - r]++;
+        }
+        return p;
+    }
+
+    struct Shelter {
+        int near[2] = {}, far[2] = {}, missing[2] = {};
+    };
+
+    // Pawn shield in front of a king on the wing (castled position)
+    Shelter countShelter(const Board& board) {
+        Shelter s;
+        for (int i = 0; i < 2; i++) {
+            Color color = static_cast<Color>(i);
+            Square king = board.findKing(color);
+            if (king >= 64) continue;
+            int kf = fileOf(king), kr = rankOf(king);
+            if (kf >= 2 && kf <= 5) continue;
+
+            Bitboard pawns = board.getPieceBitboard(PieceType::PAWN, color);
+            int dir = (color == Color::WHITE) ? 1 : -1;
+            for (int f = std::max(0, kf - 1); f <= std::min(7, kf + 1); f++) {
+                bool found = false;
+                for (int d = 1; d <= 2 && !found; d++) {
+                    int r = kr + d * dir;
+                    if (r < 0 || r >= 8) break;
+                    if (getBit(pawns, makeSquare(f, r))) {
+                        (d == 1 ? s.near[i] : s.far[i])++;
+                        found = true;
+                    }
+                }
+                if (!found) s.missing[i]++; // open file in front of king
+            }
+        }
+        return s;
+    }
+
+    // Endgame mop-up: when one side is a rook or more ahead and the defender
+    // has no pawns, reward driving the enemy king to the edge and bringing
+    // our king close so basic mates (KR-K, KQ-K) get converted.
+    int mopUpBonus(Square winnerKing, Square loserKing) {
+        int lf = fileOf(loserKing), lr = rankOf(loserKing);
+        int centerDist = std::max(3 - std::min(lf, 7 - lf), 0) +
+                         std::max(3 - std::min(lr, 7 - lr), 0);
+        int kingDist = std::abs(fileOf(winnerKing) - lf) +
+                       std::abs(rankOf(winnerKing) - lr);
+        return 10 * centerDist + 4 * (14 - kingDist);
+    }
+
+    // White-relative mop-up for the side a rook or more ahead
+    int mopUp(const Board& board, int materialW, int materialB) {
+        Square wk = board.findKing(Color::WHITE);
+        Square bk = board.findKing(Color::BLACK);
+        if (wk >= 64 || bk >= 64) return 0;
+        if (materialW - materialB >= 400 && board.getPieceBitboard(PieceType::PAWN, Color::BLACK) == 0)
+            return mopUpBonus(wk, bk);
+        if (materialB - materialW >= 400 && board.getPieceBitboard(PieceType::PAWN, Color::WHITE) == 0)
+            return -mopUpBonus(bk, wk);
+        return 0;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Default weights
+// ---------------------------------------------------------------------------
+
+EvalParams Evaluation::params = {
+    // pieceMG, pieceEG. Endgame values: knights lose value as the board
+    // empties, bishops, rooks and pawns gain it (see pieceValueEG).
+    {100, 320, 330, 500, 1000},
+    {115, 300, 345, 520, 1000},
+
+    // pstMG
+    {
+        // pawn
+        {
+             0,  0,  0,  0,  0,  0,  0,  0,
+             5, 10, 10,-20,-20, 10, 10,  5,
+             5, -5,-10,  0,  0,-10, -5,  5,
+             0,  0,  0, 20, 20,  0,  0,  0,
+             5,  5, 10, 25, 25, 10,  5,  5,
+            10, 10, 20, 30, 30, 20, 10, 10,
+            50, 50, 50, 50, 50, 50, 50, 50,
+             0,  0,  0,  0,  0,  0,  0,  0
+        },
+        // knight
+        {
+            -50,-40,-30,-30,-30,-30,-40,-50,
+            -40,-20,  0,  5,  5,  0,-20,-40,
+            -30,  5, 10, 15, 15, 10,  5,-30,
+            -30,  0, 15, 20, 20, 15,  0,-30,
+            -30,  5, 15, 20, 20, 15,  5,-30,
+            -30,  0, 10, 15, 15, 10,  0,-30,
+            -40,-20,  0,  0,  0,  0,-20,-40,
+            -50,-40,-30,-30,-30,-30,-40,-50
+        },
+        // bishop
+        {
+            -20,-10,-10,-10,-10,-10,-10,-20,
+            -10,  5,  0,  0,  0,  0,  5,-10,
+            -10, 10, 10, 10, 10, 10, 10,-10,
+            -10,  0, 10, 10, 10, 10,  0,-10,
+            -10,  5,  5, 10, 10,  5,  5,-10,
+            -10,  0,  5, 10, 10,  5,  0,-10,
+            -10,  0,  0,  0,  0,  0,  0,-10,
+            -20,-10,-10,-10,-10,-10,-10,-20
+        },
+        // rook
+        {
+             0,  0,  0,  5,  5,  0,  0,  0,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+             5, 10, 10, 10, 10, 10, 10,  5,
+             0,  0,  0,  0,  0,  0,  0,  0
+        },
+        // queen
+        {
+            -20,-10,-10, -5, -5,-10,-10,-20,
+            -10,  0,  5,  0,  0,  0,  0,-10,
+            -10,  5,  5,  5,  5,  5,  0,-10,
+              0,  0,  5,  5,  5,  5,  0, -5,
+             -5,  0,  5,  5,  5,  5,  0, -5,
+            -10,  0,  5,  5,  5,  5,  0,-10,
+            -10,  0,  0,  0,  0,  0,  0,-10,
+            -20,-10,-10, -5, -5,-10,-10,-20
+        },
+        // king: stay castled behind the pawns
+        {
+             20, 30, 10,  0,  0, 10, 30, 20,
+             20, 20,  0,  0,  0,  0, 20, 20,
+            -10,-20,-20,-20,-20,-20,-20,-10,
+            -20,-30,-30,-40,-40,-30,-30,-20,
+            -30,-40,-40,-50,-50,-40,-40,-30,
+            -30,-40,-40,-50,-50,-40,-40,-30,
+            -30,-40,-40,-50,-50,-40,-40,-30,
+            -30,-40,-40,-50,-50,-40,-40,-30
+        }
+    },
+    // pstEG
+    {
+        // pawn: only advancement matters, and it matters a lot
+        {
+              0,   0,   0,   0,   0,   0,   0,   0,
+             10,  10,  10,  10,  10,  10,  10,  10,
+             10,  10,  10,  10,  10,  10,  10,  10,
+             20,  20,  20,  20,  20,  20,  20,  20,
+             35,  35,  35,  35,  35,  35,  35,  35,
+             60,  60,  60,  60,  60,  60,  60,  60,
+            100, 100, 100, 100, 100, 100, 100, 100,
+              0,   0,   0,   0,   0,   0,   0,   0
+        },
+        // knight
+        {
+            -50,-40,-30,-30,-30,-30,-40,-50,
+            -40,-20,  0,  5,  5,  0,-20,-40,
+            -30,  5, 10, 15, 15, 10,  5,-30,
+            -30,  0, 15, 20, 20, 15,  0,-30,
+            -30,  5, 15, 20, 20, 15,  5,-30,
+            -30,  0, 10, 15, 15, 10,  0,-30,
+            -40,-20,  0,  0,  0,  0,-20,-40,
+            -50,-40,-30,-30,-30,-30,-40,-50
+        },
+        // bishop
+        {
+            -20,-10,-10,-10,-10,-10,-10,-20,
+            -10,  5,  0,  0,  0,  0,  5,-10,
+            -10, 10, 10, 10, 10, 10, 10,-10,
+            -10,  0, 10, 10, 10, 10,  0,-10,
+            -10,  5,  5, 10, 10,  5,  5,-10,
+            -10,  0,  5, 10, 10,  5,  0,-10,
+            -10,  0,  0,  0,  0,  0,  0,-10,
+            -20,-10,-10,-10,-10,-10,-10,-20
+        },
+        // rook
+        {
+             0,  0,  0,  5,  5,  0,  0,  0,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+            -5,  0,  0,  0,  0,  0,  0, -5,
+             5, 10, 10, 10, 10, 10, 10,  5,
+             0,  0,  0,  0,  0,  0,  0,  0
+        },
+        // queen
+        {
+            -20,-10,-10, -5, -5,-10,-10,-20,
+            -10,  0,  5,  0,  0,  0,  0,-10,
+            -10,  5,  5,  5,  5,  5,  0,-10,
+              0,  0,  5,  5,  5,  5,  0, -5,
+             -5,  0,  5,  5,  5,  5,  0, -5,
+            -10,  0,  5,  5,  5,  5,  0,-10,
+            -10,  0,  0,  0,  0,  0,  0,-10,
+            -20,-10,-10, -5, -5,-10,-10,-20
+        },
+        // king: a fighting piece, centralize it
+        {
+            -50,-40,-30,-20,-20,-30,-40,-50,
+            -30,-20,-10,  0,  0,-10,-20,-30,
+            -30,-10, 20, 30, 30, 20,-10,-30,
+            -30,-10, 30, 40, 40, 30,-10,-30,
+            -30,-10, 30, 40, 40, 30,-10,-30,
+            -30,-10, 20, 30, 30, 20,-10,-30,
+            -30,-30,  0,  0,  0,  0,-30,-30,
+            -50,-30,-30,-30,-30,-30,-30,-50
+        }
+    },
+    30, 30,                               // bishop pair
+
+    {4, 5, 2, 1}, {4, 5, 4, 2},           // mobility
+    {30, 30, 60, 100},                    // attackWeight
+    20, 15,                               // pawnAttackWeight, defenderWeight
+    // An enemy pawn near the king, by how many ranks away it still is. A
+    // storm both opens lines and gains tempo, so it is dangerous well
+    // before it makes contact.
+    {0, 70, 45, 25, 12, 5, 0, 0},
+    50, 35,                               // openLineOnFile, openLineBeside
+    // The original weighting, which can only ever discount the raw units.
+    {0, 0,  50,  75,  88,  94,  97,  99},
+    // Danger grows faster than the count of attackers: one piece pointed at
+    // the king is nothing, two is an annoyance, four with a line open is
+    // usually decisive. Entries above 100 amplify.
+    {0, 0, 100, 175, 250, 300, 340, 360},
+    100,                                  // kingDangerScale
+
+    15, 8, 30, 15,                        // rook on semi-open / open file
+    -20, -20, -15, -15,                   // doubled, isolated (per pawn)
+    {0, 10, 20, 35, 55,  80, 110, 0},     // passedMG
+    {0, 20, 35, 60, 95, 140, 200, 0},     // passedEG
+    15, 8, -10                            // shield pawn one / two ranks ahead, missing
+};
+
+// ---------------------------------------------------------------------------
+
+int Evaluation::evaluate(const Board& board) {
+    // Positions where no side can ever mate are dead draws
+    if (board.isInsufficientMaterial()) return 0;
+
+    // Known endgames have their own, exact or more accurate, evaluation
+    int known;
+    if (Endgames::evaluate(board, known)) return known;
+
+    // Tapered eval: score the position from a middlegame and an endgame
+    // perspective and blend by how much material is left, so e.g. the king
+    // hides behind pawns early but centralizes once the queens come off.
+    int mg = 0, eg = 0;
+    int materialW = 0, materialB = 0;
+
+    // Material, bishop pair and piece-square tables
+    material(board, mg, eg, materialW, materialB);
+
+    // Mobility and attack-based king danger, sharing one pass over the pieces
+    mobilityAndKingSafety(board, mg, eg);
+
+    // Rooks on open and semi-open files
+    rookFiles(board, mg, eg);
+
+    // Pawn structure
+    pawnStructure(board, mg, eg);
+
+    // King safety matters while there is attacking material; fade it out
+    mg += kingShelter(board);
+
+    // Mop-up knowledge for converting big material advantages without pawns
+    eg += mopUp(board, materialW, materialB);
+
+    // Material the stronger side cannot convert pulls the endgame score to 0
+    if (eg != 0)
+        eg = eg * Endgames::scaleFactor(board, eg > 0 ? Color::WHITE : Color::BLACK) / Endgames::SCALE_NORMAL;
+
+    int phase = gamePhase(board);
+    return (mg * phase + eg * (24 - phase)) / 24;
+}
+
+void Evaluation::material(const Board& board, int& mg, int& eg, int& materialW, int& materialB) {
+    for (int c = 0; c < 2; c++) {
+        Color color = static_cast<Color>(c);
+        int sign = (color == Color::WHITE) ? 1 : -1;
+        for (int t = 0; t < 6; t++) {
+            PieceType type = static_cast<PieceType>(t);
+            Bitboard bb = board.getPieceBitboard(type, color);
+            while (bb) {
+                Square sq = firstSquare(bb);
+                bb &= bb - 1;
+                int value   = pieceValue(type);
+                int valueEG = pieceValueEG(type);
+                mg += sign * (value   + positionalValue(type, sq, color, false));
+                eg += sign * (valueEG + positionalValue(type, sq, color, true));
+                if (type != PieceType::KING)
+                    (color == Color::WHITE ? materialW : materialB) += value;
+            }
+        }
+    }
+
+    // Bishop pair
+    for (int c = 0; c < 2; c++) {
+        if (popCount(board.getPieceBitboard(PieceType::BISHOP, static_cast<Color>(c))) < 2) continue;
+        int sign = c == 0 ? 1 : -1;
+        mg += sign * params.bishopPairMG;
+        eg += sign * params.bishopPairEG;
+    }
+}
+
+void Evaluation::mobilityAndKingSafety(const Board& board, int& mg, int& eg) {
+    const EvalParams& p = params;
+    Activity a;
+    countActivity(board, a);
+
+    for (int i = 0; i < 2; i++) {
+        int sign = (i == 0) ? 1 : -1;
+        for (int k = 0; k < 4; k++) {
+            mg += sign * a.mobility[i][k] * p.mobilityMG[k];
+            eg += sign * a.mobility[i][k] * p.mobilityEG[k];
+        }
+    }
+
+    for (int i = 0; i < 2; i++) {
+        const KingZone& kz = a.kz[i];
+        if (kz.sq >= 64) continue;
+        int danger = 0;
+        for (int k = 0; k < 4; k++) danger += p.attackWeight[k] * kz.hits[k];
+        if (KS_NEW_TERMS) {
+            for (int d = 0; d < 8; d++) danger += p.stormByRankDist[d] * kz.storm[d];
+            danger += p.pawnAttackWeight * kz.pawnHits +
+                      p.openLineOnFile * kz.openOnFile + p.openLineBeside * kz.openBeside;
+            // an attack is local superiority, so defenders come off the total
+            danger -= p.defenderWeight * kz.defenderHits;
+        }
+        if (danger < 0) danger = 0;
+        danger = danger * (KS_NEW_RAMP ? p.attackRampNew : p.attackRamp)[rampSlot(kz)] / 100;
+        danger = danger * p.kingDangerScale / 100;
+        mg += (i == 0) ? -danger : danger;
+    }
+}
+
+void Evaluation::rookFiles(const Board& board, int& mg, int& eg) {
+    RookFiles r = countRookFiles(board);
+    for (int i = 0; i < 2; i++) {
+        int sign = (i == 0) ? 1 : -1;
+        mg += sign * (r.semiOpen[i] * params.rookSemiOpenMG + r.open[i] * params.rookOpenMG);
+        eg += sign * (r.semiOpen[i] * params.rookSemiOpenEG + r.open[i] * params.rookOpenEG);
+    }
+}
+
+void Evaluation::pawnStructure(const Board& board, int& mg, int& eg) {
+    const EvalParams& p = params;
+    PawnFeatures f = countPawns(board);
+    for (int i = 0; i < 2; i++) {
+        int sign = (i == 0) ? 1 : -1;
+        mg += sign * (f.doubled[i] * p.doubledMG + f.isolated[i] * p.isolatedMG);
+        eg += sign * (f.doubled[i] * p.doubledEG + f.isolated[i] * p.isolatedEG);
+        for (int r = 1; r < 7; r++) {
+            mg += sign * f.passed[i][r] * p.passedMG[r];
+            eg += sign * f.passed[i][r] * p.passedEG[r];
+        }
+    }
+}
+
+int Evaluation::kingShelter(const Board& board) {
+    Shelter s = countShelter(board);
+    int score = 0;
+    for (int i = 0; i < 2; i++) {
+        int shield = s.near[i] * params.shieldNear + s.far[i] * params.shieldFar +
+                     s.missing[i] * params.shieldMissing;
+        score += (i == 0) ? shield : -shield;
+    }
+    return score;
+}
+
+int Evaluation::gamePhase(const Board& board) {
+    int phase = 0;
+    for (Color c : {Color::WHITE, Color::BLACK}) {
+        phase += popCount(board.getPieceBitboard(PieceType::KNIGHT, c));
+        phase += popCount(board.getPieceBitboard(PieceType::BISHOP, c));
+        phase += popCount(board.getPieceBitboard(PieceType::ROOK,   c)) * 2;
+        phase += popCount(board.getPieceBitboard(PieceType::QUEEN,  c)) * 4;
+    }
+    return std::min(phase, 24);
+}
+
+// ---------------------------------------------------------------------------
+
+// Flat index of a weight
+#define PARAM(field) evalParamIndex(offsetof(EvalParams, field))
+
+bool Evaluation::trace(const Board& board, EvalTrace& t) {
+    if (board.isInsufficientMaterial()) return false;
+    int known;
+    if (Endgames::evaluate(board, known)) return false;
+
+    std::memset(&t, 0, sizeof(t));
+
+    // Material and piece-square tables
+    for (int c = 0; c < 2; c++) {
+        Color color = static_cast<Color>(c);
+        int sign = (c == 0) ? 1 : -1;
+        for (int type = 0; type < 6; type++) {
+            Bitboard bb = board.getPieceBitboard(static_cast<PieceType>(type), color);
+            while (bb) {
+                Square sq = firstSquare(bb); bb &= bb - 1;
+                int idx = (c == 0 ? rankOf(sq) : 7 - rankOf(sq)) * 8 + fileOf(sq);
+                if (type < 5) {
+                    t.mg[PARAM(pieceMG) + type] += sign;
+                    t.eg[PARAM(pieceEG) + type] += sign;
+                }
+                t.mg[PARAM(pstMG) + type * 64 + idx] += sign;
+                t.eg[PARAM(pstEG) + type * 64 + idx] += sign;
+            }
+        }
+        if (popCount(board.getPieceBitboard(PieceType::BISHOP, color)) >= 2) {
+            t.mg[PARAM(bishopPairMG)] += sign;
+            t.eg[PARAM(bishopPairEG)] += sign;
+        }
+    }
+
+    // Mobility and king danger
+    Activity a;
+    countActivity(board, a);
+    for (int i = 0; i < 2; i++) {
+        int sign = (i == 0) ? 1 : -1;
+        for (int k = 0; k < 4; k++) {
+            t.mg[PARAM(mobilityMG) + k] += sign * a.mobility[i][k];
+            t.eg[PARAM(mobilityEG) + k] += sign * a.mobility[i][k];
+        }
+
+        const KingZone& kz = a.kz[i];
+        int* units = t.kingUnits[i];
+        for (int k = 0; k < 4; k++) units[PARAM(attackWeight) + k] = kz.hits[k];
+        for (int d = 0; d < 8; d++) units[PARAM(stormByRankDist) + d] = kz.storm[d];
+        units[PARAM(pawnAttackWeight)] = kz.pawnHits;
+        units[PARAM(defenderWeight)]   = -kz.defenderHits;
+        units[PARAM(openLineOnFile)]   = kz.openOnFile;
+        units[PARAM(openLineBeside)]   = kz.openBeside;
+        t.rampIndex[i] = (KS_NEW_RAMP ? PARAM(attackRampNew) : PARAM(attackRamp)) + rampSlot(kz);
+        if (kz.sq >= 64) std::memset(units, 0, sizeof(t.kingUnits[i]));
+    }
+
+    // Rook files, pawn structure and shelter
+    RookFiles r = countRookFiles(board);
+    PawnFeatures f = countPawns(board);
+    Shelter s = countShelter(board);
+    for (int i = 0; i < 2; i++) {
+        int sign = (i == 0) ? 1 : -1;
+        t.mg[PARAM(rookSemiOpenMG)] += sign * r.semiOpen[i];
+        t.eg[PARAM(rookSemiOpenEG)] += sign * r.semiOpen[i];
+        t.mg[PARAM(rookOpenMG)]     += sign * r.open[i];
+        t.eg[PARAM(rookOpenEG)]     += sign * r.open[i];
+
+        t.mg[PARAM(doubledMG)]  += sign * f.doubled[i];
+        t.eg[PARAM(doubledEG)]  += sign * f.doubled[i];
+        t.mg[PARAM(isolatedMG)] += sign * f.isolated[i];
+        t.eg[PARAM(isolatedEG)] += sign * f.isolated[i];
+        for (int rank = 1; rank < 7; rank++) {
+            t.mg[PARAM(passedMG) + rank] += sign * f.passed[i][rank];
+            t.eg[PARAM(passedEG) + rank] += sign * f.passed[i][rank];
+        }
+
+        t.mg[PARAM(shieldNear)]    += sign * s.near[i];
+        t.mg[PARAM(shieldFar)]     += sign * s.far[i];
+        t.mg[PARAM(shieldMissing)] += sign * s.missing[i];
+    }
+
+    // The rest is fixed: mop-up, and the scale factor, which depends on
+    // the sign of the endgame score and is taken at the current weights
+    int mg = 0, eg = 0, materialW = 0, materialB = 0;
+    material(board, mg, eg, materialW, materialB);
+    mobilityAndKingSafety(board, mg, eg);
+    rookFiles(board, mg, eg);
+    pawnStructure(board, mg, eg);
+    t.fixedEG = mopUp(board, materialW, materialB);
+    eg += t.fixedEG;
+    t.scale = eg ? Endgames::scaleFactor(board, eg > 0 ? Color::WHITE : Color::BLACK) : Endgames::SCALE_NORMAL;
+    t.phase = gamePhase(board);
+    return true;
+}
+
+#undef PARAM
+
+// ---------------------------------------------------------------------------
+
+int Evaluation::pieceValue(PieceType type) {
+    if (type == PieceType::KING) return 20000;
+    if (type == PieceType::NONE) return 0;
+    return params.pieceMG[static_cast<int>(type)];
+}
+
+int Evaluation::pieceValueEG(PieceType type) {
+    if (type == PieceType::KING) return 20000;
+    if (type == PieceType::NONE) return 0;
+    return params.pieceEG[static_cast<int>(type)];
+}
+
+int Evaluation::positionalValue(PieceType type, Square square, Color color, bool endgame) {
+    if (type == PieceType::NONE) return 0;
+    int rank = rankOf(square);
+    int idx = ((color == Color::BLACK) ? (7 - rank) : rank) * 8 + fileOf(square);
+    return (endgame ? params.pstEG : params.pstMG)[static_cast<int>(type)][idx];
+}
@@ -0,0 +1,100 @@
+#ifndef EVALUATE_H
+#define EVALUATE_H
+
+#include "types.h"
+#include "board.h"
+#include <cstddef>
+
+// Every evaluation weight, in centipawns. All members are int, so the
+// struct can also be read as a flat array of EVAL_PARAM_COUNT weights,
+// which is how the tuner (tools/tune) addresses them. Piece-square tables
+// are from white's side, a1 = 0.
+struct EvalParams {
+    int pieceMG[5], pieceEG[5];           // pawn..queen
+    int pstMG[6][64], pstEG[6][64];       // pawn..king
+    int bishopPairMG, bishopPairEG;
+
+    int mobilityMG[4], mobilityEG[4];     // knight, bishop, rook, queen
+    int attackWeight[4];                  // per attacked king-zone square
+    int pawnAttackWeight;                 // KS_NEW_TERMS only, as are the
+    int defenderWeight;                   // four entries after it
+    int stormByRankDist[8];
+    int openLineOnFile, openLineBeside;
+    int attackRamp[8];                    // percent, by attacker count
+    int attackRampNew[8];                 // KS_NEW_RAMP
+    int kingDangerScale;                  // percent
+
+    int rookSemiOpenMG, rookSemiOpenEG, rookOpenMG, rookOpenEG;
+    int doubledMG, doubledEG, isolatedMG, isolatedEG;
+    int passedMG[8], passedEG[8];         // by rank, from the pawn's side
+    int shieldNear, shieldFar, shieldMissing;
+};
+
+constexpr int EVAL_PARAM_COUNT = sizeof(EvalParams) / sizeof(int);
+
+// Flat index of a member, e.g. evalParamIndex(offsetof(EvalParams, passedMG))
+constexpr int evalParamIndex(std::size_t offset) { return static_cast<int>(offset / sizeof(int)); }
+
+// The evaluation written as coefficients of the weights, for tuning.
+// mg/eg hold how many times each weight is added to the white-relative
+// middlegame and endgame sums. King danger is the one non-linear term:
+// per king (white, black), the danger units are the sum of kingUnits[i] *
+// weight i, and the danger max(units, 0) * attackRamp entry / 100 *
+// kingDangerScale / 100 comes off that king's side in the middlegame.
+// Everything not covered by a weight (mop-up) is in fixedEG, and the
+// endgame sum is scaled by scale / Endgames::SCALE_NORMAL before blending.
+struct EvalTrace {
+    int mg[EVAL_PARAM_COUNT], eg[EVAL_PARAM_COUNT];
+    int kingUnits[2][EVAL_PARAM_COUNT];
+    int rampIndex[2];       // flat index of the attackRamp(New) entry in use
+    int fixedEG;
+    int phase;
+    int scale;
+};
+
+// Static evaluation in centipawns, white-relative.
+//
+// evaluate() is all the search needs. The individual terms are public so
+// tools can time or inspect them one at a time; each adds its white-relative
+// middlegame and endgame parts to mg/eg, and evaluate() blends the totals by
+// game phase.
+class Evaluation {
+public:
+    // The weights in use; the defaults are in evaluate.cpp
+    static EvalParams params;
+
+    static int evaluate(const Board& board);
+
+    // Fills trace for a position that evaluate() scores by its general
+    // terms. Returns false (trace untouched) for insufficient material and
+    // the known endgames, which do not depend on the weights.
+    static bool trace(const Board& board, EvalTrace& trace);
+
+    // Material, bishop pair and piece-square tables. materialW/B receive the
+    // flat (middlegame) material of each side, kings excluded.
+    static void material(const Board& board, int& mg, int& eg, int& materialW, int& materialB);
+    // Mobility and attack-based king danger, sharing one pass over the pieces
+    static void mobilityAndKingSafety(const Board& board, int& mg, int& eg);
+    // Rooks on open and semi-open files
+    static void rookFiles(const Board& board, int& mg, int& eg);
+    // Doubled, isolated and passed pawns (passers are worth much more as
+    // material comes off)
+    static void pawnStructure(const Board& board, int& mg, int& eg);
+    // Pawn shelter in front of a castled king; middlegame only
+    static int kingShelter(const Board& board);
+    // 24 = all minor/major pieces on the board (middlegame), 0 = bare kings
+    // and pawns (pure endgame)
+    static int gamePhase(const Board& board);
+
+    static int pieceValue(PieceType type);
+    // Endgame-specific material values: knights lose value as the board
+    // empties (fewer outposts/pawns to leap around), while bishops, rooks,
+    // and pawns gain value on a more open board or in a promotion race
+    // (classical piece-value tapering, e.g. Kaufman 1999). Used only for the
+    // eg half of the material sum; SEE, MVV-LVA ordering, and the mop-up
+    // material-diff threshold keep using the flat pieceValue.
+    static int pieceValueEG(PieceType type);
+    static int positionalValue(PieceType type, Square square, Color color, bool endgame);
+};
+
+#endif // EVALUATE_H
@@ -1,11 +1,61 @@
 #include "uci.h"
 #include "board.h"
+#include "bench.h"
+#include "datagen.h"
+#include "batch.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 int main(int argc, char* argv[]) {
     // Force unbuffered stdout so UCI GUIs receive each line immediately
     std::cout << std::unitbuf;
+
+    // chess_engine bench [depth] [threads] [hash MB]
+    if (argc > 1 && std::strcmp(argv[1], "bench") == 0) {
+        int depth   = argc > 2 ? std::atoi(argv[2]) : 8;
+        int threads = argc > 3 ? std::atoi(argv[3]) : 1;
+        int hashMB  = argc > 4 ? std::atoi(argv[4]) : 16;
+        Benchmark::run(depth > 0 ? depth : 8, threads, hashMB > 0 ? hashMB : 16, std::cout);
+        return 0;
+    }
+
+    // chess_engine datagen [file] [games] [nodes per move] [threads] [random plies]
+    if (argc > 1 && std::strcmp(argv[1], "datagen") == 0) {
+        DataGenerator::Options options;
+        if (argc > 2) options.path        = argv[2];
+        if (argc > 3) options.games       = std::max(1, std::atoi(argv[3]));
+        if (argc > 4) options.nodes       = std::max(1, std::atoi(argv[4]));
+        if (argc > 5) options.threads     = std::atoi(argv[5]);
+        if (argc > 6) options.randomPlies = std::max(0, std::atoi(argv[6]));
+        if (DataGenerator::run(options, std::cerr) < 0) {
+            std::cerr << "cannot write " << options.path << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // chess_engine batch [eval|qsearch|search] [depth] [threads] < fens > results
+    if (argc > 1 && std::strcmp(argv[1], "batch") == 0) {
+        BatchRunner::Options options;
+        if (argc > 2) {
+            if (std::strcmp(argv[2], "eval") == 0)         options.mode = BatchRunner::Mode::Eval;
+            else if (std::strcmp(argv[2], "qsearch") == 0) options.mode = BatchRunner::Mode::QSearch;
+            else if (std::strcmp(argv[2], "search") == 0)  options.mode = BatchRunner::Mode::Search;
+            else {
+                std::cerr << "unknown batch mode " << argv[2] << " (eval, qsearch or search)" << std::endl;
+                return 1;
+            }
+        }
+        if (argc > 3) options.depth   = std::max(1, std::atoi(argv[3]));
+        if (argc > 4) options.threads = std::atoi(argv[4]);
+        std::cout << std::nounitbuf;  // BatchRunner flushes per run of finished lines
+        BatchRunner::run(options, std::cin, std::cout);
+        return 0;
+    }
+
     UCIEngine engine(argc > 0 ? argv[0] : "");
     engine.run();
     return 0;
-}
\ No newline at end of file
+}
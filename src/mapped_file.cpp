@@ -0,0 +1,114 @@
+#include "mapped_file.h"
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+    close();
+    std::swap(base, other.base);
+    std::swap(length, other.length);
+    std::swap(opened, other.opened);
+#ifdef _WIN32
+    std::swap(fileHandle, other.fileHandle);
+    std::swap(mappingHandle, other.mappingHandle);
+#endif
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path, Access access) {
+    close();
+    DWORD flags = (access == Access::Random) ? FILE_FLAG_RANDOM_ACCESS
+                                             : FILE_FLAG_SEQUENTIAL_SCAN;
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) { CloseHandle(file); return false; }
+    if (size.QuadPart == 0) {  // CreateFileMapping rejects empty files
+        CloseHandle(file);
+        opened = true;
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) { CloseHandle(file); return false; }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) { CloseHandle(mapping); CloseHandle(file); return false; }
+
+    fileHandle    = file;
+    mappingHandle = mapping;
+    base   = static_cast<const unsigned char*>(view);
+    length = static_cast<std::size_t>(size.QuadPart);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (base) UnmapViewOfFile(base);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+    base = nullptr;
+    length = 0;
+    opened = false;
+    fileHandle = mappingHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path, Access access) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) { ::close(fd); return false; }
+    if (st.st_size == 0) {  // mmap rejects a zero length
+        ::close(fd);
+        opened = true;
+        return true;
+    }
+
+    // The mapping keeps its own reference to the file, so the descriptor
+    // can be closed straight away.
+    void* p = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) return false;
+    madvise(p, static_cast<std::size_t>(st.st_size),
+            access == Access::Random ? MADV_RANDOM : MADV_SEQUENTIAL);
+
+    base   = static_cast<const unsigned char*>(p);
+    length = static_cast<std::size_t>(st.st_size);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (base) munmap(const_cast<unsigned char*>(base), length);
+    base = nullptr;
+    length = 0;
+    opened = false;
+}
+
+#endif
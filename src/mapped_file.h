@@ -0,0 +1,49 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file (books, tablebases, data files).
+//
+// The pages are mapped shared and never written, so every engine process on
+// a host that maps the same file uses one physical copy from the page cache,
+// and opening a file costs no reading or copying up front - pages are faulted
+// in as they are touched. The mapping lives as long as the object.
+class MappedFile {
+public:
+    // How the file will be read; lets the OS pick a readahead policy.
+    enum class Access { Sequential, Random };
+
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // False if the file is missing or cannot be mapped. An empty file opens
+    // successfully with size() == 0.
+    bool open(const std::string& path, Access access = Access::Sequential);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const unsigned char* data() const { return base; }
+    std::size_t size() const { return length; }
+    std::string_view view() const {
+        return {reinterpret_cast<const char*>(base), length};
+    }
+
+private:
+    const unsigned char* base = nullptr;
+    std::size_t length = 0;
+    bool opened = false;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
+
+#endif // MAPPED_FILE_H
@@ -3,25 +3,36 @@
 #include <iostream>
 
 std::vector<Move> MoveGenerator::generateLegalMoves(const Board& board) {
-    std::vector<Move> pseudoLegalMoves = generatePseudoLegalMoves(board);
-    std::vector<Move> legalMoves;
-    legalMoves.reserve(pseudoLegalMoves.size());
+    MoveList moves;
+    generateLegalMoves(board, moves);
+    return std::vector<Move>(moves.begin(), moves.end());
+}
+
+void MoveGenerator::generateLegalMoves(const Board& board, MoveList& moves) {
+    generatePseudoLegalMoves(board, moves);
 
     // makeMove/unmakeMove restores the board exactly, so filter on the board
     // itself instead of copying it (and its whole history) once per move.
+    // Legal moves are compacted in place, keeping generation order.
     Board& b = const_cast<Board&>(board);
     Color side = board.getSideToMove();
-    for (const Move& move : pseudoLegalMoves) {
-        b.makeMove(move);
-        if (!b.isInCheck(side)) legalMoves.push_back(move);
-        b.unmakeMove(move);
+    std::size_t legal = 0;
+    for (std::size_t i = 0; i < moves.size(); i++) {
+        b.makeMove(moves[i]);
+        if (!b.isInCheck(side)) moves[legal++] = moves[i];
+        b.unmakeMove(moves[i]);
     }
-
-    return legalMoves;
+    moves.resize(legal);
 }
 
 std::vector<Move> MoveGenerator::generatePseudoLegalMoves(const Board& board) {
-    std::vector<Move> moves;
+    MoveList moves;
+    generatePseudoLegalMoves(board, moves);
+    return std::vector<Move>(moves.begin(), moves.end());
+}
+
+void MoveGenerator::generatePseudoLegalMoves(const Board& board, MoveList& moves) {
+    moves.clear();
     Color sideToMove = board.getSideToMove();
     
     // Generate moves for all pieces of the current side using bitboards
@@ -60,11 +71,9 @@ std::vector<Move> MoveGenerator::generatePseudoLegalMoves(const Board& board) {
     
     // Generate castling moves
     generateCastlingMoves(board, moves);
-    
-    return moves;
 }
 
-void MoveGenerator::generatePawnMoves(const Board& board, Square sq, std::vector<Move>& moves) {
+void MoveGenerator::generatePawnMoves(const Board& board, Square sq, MoveList& moves) {
     Color color = board.pieceAt(sq).color;
     int file = fileOf(sq);
     int rank = rankOf(sq);
@@ -186,7 +195,7 @@ void MoveGenerator::generatePawnMoves(const Board& board, Square sq, std::vector
     }
 }
 
-void MoveGenerator::generateKnightMoves(const Board& board, Square sq, std::vector<Move>& moves) {
+void MoveGenerator::generateKnightMoves(const Board& board, Square sq, MoveList& moves) {
     Color color = board.pieceAt(sq).color;
     Bitboard knightAttacks = getKnightAttacks(sq);
     Bitboard enemyPieces = (color == Color::WHITE) ? board.getBlackPieces() : board.getWhitePieces();
@@ -208,7 +217,7 @@ void MoveGenerator::generateKnightMoves(const Board& board, Square sq, std::vect
     }
 }
 
-void MoveGenerator::generateBishopMoves(const Board& board, Square sq, std::vector<Move>& moves) {
+void MoveGenerator::generateBishopMoves(const Board& board, Square sq, MoveList& moves) {
     Color color = board.pieceAt(sq).color;
     Bitboard bishopAttacks = getBishopAttacks(sq, board.getAllPieces());
     Bitboard enemyPieces = (color == Color::WHITE) ? board.getBlackPieces() : board.getWhitePieces();
@@ -230,7 +239,7 @@ void MoveGenerator::generateBishopMoves(const Board& board, Square sq, std::vect
     }
 }
 
-void MoveGenerator::generateRookMoves(const Board& board, Square sq, std::vector<Move>& moves) {
+void MoveGenerator::generateRookMoves(const Board& board, Square sq, MoveList& moves) {
     Color color = board.pieceAt(sq).color;
     Bitboard rookAttacks = getRookAttacks(sq, board.getAllPieces());
     Bitboard enemyPieces = (color == Color::WHITE) ? board.getBlackPieces() : board.getWhitePieces();
@@ -252,7 +261,7 @@ void MoveGenerator::generateRookMoves(const Board& board, Square sq, std::vector
     }
 }
 
-void MoveGenerator::generateQueenMoves(const Board& board, Square sq, std::vector<Move>& moves) {
+void MoveGenerator::generateQueenMoves(const Board& board, Square sq, MoveList& moves) {
     Color color = board.pieceAt(sq).color;
     Bitboard queenAttacks = getQueenAttacks(sq, board.getAllPieces());
     Bitboard enemyPieces = (color == Color::WHITE) ? board.getBlackPieces() : board.getWhitePieces();
@@ -274,7 +283,7 @@ void MoveGenerator::generateQueenMoves(const Board& board, Square sq, std::vecto
     }
 }
 
-void MoveGenerator::generateKingMoves(const Board& board, Square sq, std::vector<Move>& moves) {
+void MoveGenerator::generateKingMoves(const Board& board, Square sq, MoveList& moves) {
     Color color = board.pieceAt(sq).color;
     Bitboard kingAttacks = getKingAttacks(sq);
     Bitboard enemyPieces = (color == Color::WHITE) ? board.getBlackPieces() : board.getWhitePieces();
@@ -296,7 +305,7 @@ void MoveGenerator::generateKingMoves(const Board& board, Square sq, std::vector
     }
 }
 
-void MoveGenerator::generateCastlingMoves(const Board& board, std::vector<Move>& moves) {
+void MoveGenerator::generateCastlingMoves(const Board& board, MoveList& moves) {
     Color color = board.getSideToMove();
 
     if (board.isInCheck(color)) return; // Cannot castle in check
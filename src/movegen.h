@@ -3,15 +3,45 @@
 
 #include "types.h"
 #include "board.h"
+#include <array>
+#include <cstddef>
 #include <vector>
 
+// Fixed-capacity move list. The search keeps one per ply in preallocated
+// frames, so generating moves in the tree never touches the heap. No legal
+// position has more than 218 moves; pseudo-legal lists stay well under 256.
+class MoveList {
+public:
+    static constexpr std::size_t MAX_MOVES = 256;
+
+    void push_back(const Move& move) { moves[count++] = move; }
+    void clear() { count = 0; }
+    void resize(std::size_t n) { count = n; }  // shrink only
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Move& operator[](std::size_t i) { return moves[i]; }
+    const Move& operator[](std::size_t i) const { return moves[i]; }
+    Move* begin() { return moves.data(); }
+    Move* end() { return moves.data() + count; }
+    const Move* begin() const { return moves.data(); }
+    const Move* end() const { return moves.data() + count; }
+
+private:
+    std::array<Move, MAX_MOVES> moves;
+    std::size_t count = 0;
+};
+
 class MoveGenerator {
 public:
     // Generate all legal moves for the current position
     static std::vector<Move> generateLegalMoves(const Board& board);
+    static void generateLegalMoves(const Board& board, MoveList& moves);
     
     // Generate all pseudo-legal moves (may leave king in check)
     static std::vector<Move> generatePseudoLegalMoves(const Board& board);
+    static void generatePseudoLegalMoves(const Board& board, MoveList& moves);
 
     // All pieces of both colors attacking sq, given an occupancy (which may
     // differ from the board's, e.g. during static exchange evaluation)
@@ -27,14 +57,14 @@ public:
 
 private:
     // Generate moves for specific piece types using bitboards
-    static void generatePawnMoves(const Board& board, Square sq, std::vector<Move>& moves);
-    static void generateKnightMoves(const Board& board, Square sq, std::vector<Move>& moves);
-    static void generateBishopMoves(const Board& board, Square sq, std::vector<Move>& moves);
-    static void generateRookMoves(const Board& board, Square sq, std::vector<Move>& moves);
-    static void generateQueenMoves(const Board& board, Square sq, std::vector<Move>& moves);
-    static void generateKingMoves(const Board& board, Square sq, std::vector<Move>& moves);
+    static void generatePawnMoves(const Board& board, Square sq, MoveList& moves);
+    static void generateKnightMoves(const Board& board, Square sq, MoveList& moves);
+    static void generateBishopMoves(const Board& board, Square sq, MoveList& moves);
+    static void generateRookMoves(const Board& board, Square sq, MoveList& moves);
+    static void generateQueenMoves(const Board& board, Square sq, MoveList& moves);
+    static void generateKingMoves(const Board& board, Square sq, MoveList& moves);
     
-    static void generateCastlingMoves(const Board& board, std::vector<Move>& moves);
+    static void generateCastlingMoves(const Board& board, MoveList& moves);
     
 };
 
@@ -0,0 +1,69 @@
+#include "notation.h"
+#include "movegen.h"
+
+namespace {
+    char pieceLetter(PieceType type) {
+        switch (type) {
+            case PieceType::KNIGHT: return 'N';
+            case PieceType::BISHOP: return 'B';
+            case PieceType::ROOK:   return 'R';
+            case PieceType::QUEEN:  return 'Q';
+            case PieceType::KING:   return 'K';
+            default:                return 0;
+        }
+    }
+
+    std::string squareName(Square sq) {
+        return {static_cast<char>('a' + fileOf(sq)), static_cast<char>('1' + rankOf(sq))};
+    }
+
+    // SAN without the check suffix; legal is the position's legal move list
+    std::string sanBody(const Board& board, const Move& move, const MoveList& legal) {
+        if (move.isCastle)
+            return fileOf(move.to) == 6 ? "O-O" : "O-O-O";
+
+        PieceType type = board.pieceAt(move.from).type;
+        std::string san;
+        if (type == PieceType::PAWN) {
+            if (move.isCapture) san += static_cast<char>('a' + fileOf(move.from));
+        } else {
+            san += pieceLetter(type);
+            // Other pieces of the same type that can reach the square
+            bool ambiguous = false, sameFile = false, sameRank = false;
+            for (const Move& m : legal) {
+                if (m.to != move.to || m.from == move.from ||
+                    board.pieceAt(m.from).type != type) continue;
+                ambiguous = true;
+                sameFile |= fileOf(m.from) == fileOf(move.from);
+                sameRank |= rankOf(m.from) == rankOf(move.from);
+            }
+            if (ambiguous) {
+                if (!sameFile)      san += static_cast<char>('a' + fileOf(move.from));
+                else if (!sameRank) san += static_cast<char>('1' + rankOf(move.from));
+                else                san += squareName(move.from);
+            }
+        }
+        if (move.isCapture) san += 'x';
+        san += squareName(move.to);
+        if (move.promotion != PieceType::NONE) {
+            san += '=';
+            san += pieceLetter(move.promotion);
+        }
+        return san;
+    }
+}
+
+std::string Notation::toSan(const Board& board, const Move& move) {
+    MoveList legal;
+    MoveGenerator::generateLegalMoves(board, legal);
+    std::string san = sanBody(board, move, legal);
+
+    Board& b = const_cast<Board&>(board);
+    b.makeMove(move);
+    if (b.isInCheck(b.getSideToMove())) {
+        MoveGenerator::generateLegalMoves(b, legal);
+        san += legal.empty() ? '#' : '+';
+    }
+    b.unmakeMove(move);
+    return san;
+}
@@ -0,0 +1,18 @@
+#ifndef NOTATION_H
+#define NOTATION_H
+
+#include "types.h"
+#include "board.h"
+#include <string>
+
+// Standard algebraic notation (Nf3, exd5, O-O, e8=Q+), as written in PGN.
+class Notation {
+public:
+    // SAN for a legal move, with the minimal disambiguation and a check or
+    // mate suffix
+    static std::string toSan(const Board& board, const Move& move);
+
+    // The reverse, text to move, is PgnReader::resolveMove
+};
+
+#endif // NOTATION_H
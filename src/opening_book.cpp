@@ -1,10 +1,8 @@
 #include "opening_book.h"
 #include "eco_book.h"
-#include "movegen.h"
-#include <fstream>
-#include <sstream>
+#include "mapped_file.h"
+#include "pgn.h"
 #include <algorithm>
-#include <cctype>
 #include <iostream>
 #include <chrono>
 #include <thread>
@@ -30,229 +28,148 @@ OpeningBook::OpeningBook() : rng(seedRng()) {}
 OpeningBook::~OpeningBook() {}
 
 bool OpeningBook::loadFromFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) return false;  // caller may probe several paths
-    return parseStream(file, filename);
+    // Parse straight out of the page cache instead of reading the file into
+    // a heap buffer first; the mapping only lives for the duration of the load.
+    MappedFile file;
+    if (!file.open(filename)) return false;  // caller may probe several paths
+    staging.clear();
+    if (!parseBuffer(file.view(), filename)) return false;
+    finalize();
+    return true;
 }
 
+// Nothing to parse: the tables are already sorted in read-only data
 bool OpeningBook::loadEmbedded() {
-    std::istringstream stream(std::string(
-        reinterpret_cast<const char*>(ECO_BOOK_DATA), ECO_BOOK_SIZE));
-    return parseStream(stream, "embedded");
+    keys.clear();
+    offsets.clear();
+    moves.clear();
+    view = {ECO_BOOK_KEYS, ECO_BOOK_OFFSETS, ECO_BOOK_MOVES, ECO_BOOK_POSITIONS};
+    std::cerr << "Loaded " << ECO_BOOK_POSITIONS
+              << " positions from opening book (embedded)" << std::endl;
+    return ECO_BOOK_POSITIONS > 0;
 }
 
-bool OpeningBook::parseStream(std::istream& file, const std::string& sourceName) {
-    std::string line;
-    std::vector<std::pair<std::string, int>> currentMoves;  // move, explicit weight (-1 = none)
-    bool inGame = false;
+bool OpeningBook::loadPolyglot(const std::string& filename) {
+    if (filename.empty()) {
+        polyglot.close();
+        return true;
+    }
+    return polyglot.open(filename);  // a file that fails to open keeps the current book
+}
 
-    while (std::getline(file, line)) {
-        if (!line.empty() && line.back() == '\r') line.pop_back();
+void OpeningBook::finalize() {
+    keys.clear();
+    keys.reserve(staging.size());
+    for (const auto& position : staging) keys.push_back(position.first);
+    std::sort(keys.begin(), keys.end());
+
+    offsets.assign(1, 0);
+    offsets.reserve(keys.size() + 1);
+    moves.clear();
+    for (uint64_t key : keys) {
+        std::vector<BookMove>& list = staging[key];
+        std::stable_sort(list.begin(), list.end(), [](const BookMove& a, const BookMove& b) {
+            return a.weight > b.weight;
+        });
+        moves.insert(moves.end(), list.begin(), list.end());
+        offsets.push_back(static_cast<uint32_t>(moves.size()));
+    }
+    moves.shrink_to_fit();
+    std::unordered_map<uint64_t, std::vector<BookMove>>().swap(staging);
+    view = {keys.data(), offsets.data(), moves.data(), keys.size()};
+}
 
-        // Header lines and blank lines end the current movetext block
-        if (line.empty() || line[0] == '[') {
-            if (inGame && !currentMoves.empty()) {
-                processGame(currentMoves);
-                currentMoves.clear();
-            }
-            inGame = false;
-            continue;
-        }
+uint16_t OpeningBook::packMove(const Move& move) {
+    int promotion = move.promotion == PieceType::NONE ? 0 : static_cast<int>(move.promotion);
+    return static_cast<uint16_t>(move.from | move.to << 6 | promotion << 12);
+}
 
-        inGame = true;
-        std::istringstream iss(line);
-        std::string token;
-        while (iss >> token) {
-            if (token.back() == '.') continue;
-            if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") continue;
-            if (token[0] == '$') {
-                // An explicit weight for the move just pushed, e.g.
-                // "e2e4 $1309466" (a real master-game count). Real NAG
-                // annotations in a hand-annotated PGN would also match this
-                // and set a small weight override instead of being skipped -
-                // harmless for the embedded book (which we generate
-                // ourselves) and a minor curiosity at most for a manually
-                // dropped override file.
-                if (!currentMoves.empty()) {
-                    try { currentMoves.back().second = std::stoi(token.substr(1)); }
-                    catch (...) {}
-                }
-                continue;
-            }
-            if (token.empty() || token[0] == '{' || token[0] == ';') continue;
-            while (!token.empty() && (token.back() == '!' || token.back() == '?' ||
-                                      token.back() == '+' || token.back() == '#'))
-                token.pop_back();
-            if (!token.empty()) currentMoves.emplace_back(token, -1);
-        }
-    }
+Move OpeningBook::unpackMove(uint16_t packed) {
+    Move move(static_cast<Square>(packed & 63), static_cast<Square>((packed >> 6) & 63));
+    int promotion = (packed >> 12) & 7;
+    if (promotion) move.promotion = static_cast<PieceType>(promotion);
+    return move;
+}
 
-    if (inGame && !currentMoves.empty())
-        processGame(currentMoves);
+bool OpeningBook::parseBuffer(std::string_view data, const std::string& sourceName) {
+    PgnReader reader(data);
+    PgnGame game;  // reused, so reading allocates nothing once it has grown
+    while (reader.next(game))
+        processGame(game);
 
-    std::cerr << "Loaded " << book.size() << " positions from opening book ("
+    std::cerr << "Loaded " << staging.size() << " positions from opening book ("
               << sourceName << ")" << std::endl;
-    return !book.empty();
+    return !staging.empty();
 }
 
-void OpeningBook::processGame(const std::vector<std::pair<std::string, int>>& moves) {
+void OpeningBook::processGame(const PgnGame& game) {
     Board board;
-    for (const auto& mv : moves) {
-        Move move = parseMove(mv.first, board);
-        if (move.from == move.to && move.from == 0) return;
-        addMoveToBook(board.getHash(), move, mv.second);
+    std::string_view fen = game.tag("FEN");
+    if (!fen.empty() && !board.fromFEN(std::string(fen))) return;
+    for (const PgnMove& mv : game.moves) {
+        Move move = PgnReader::resolveMove(board, mv.text);
+        if (move.from == move.to) return;
+        // A NAG after a move is read as its explicit weight, e.g.
+        // "e4 $1309466" (a real master-game count). Real annotations in a
+        // hand-annotated PGN would also set a small weight override instead
+        // of being skipped - harmless for the embedded book (which we
+        // generate ourselves) and a minor curiosity for an override file.
+        addMoveToBook(board.getHash(), move, mv.nag);
         board.makeMove(move);
     }
 }
 
 void OpeningBook::addMoveToBook(uint64_t positionKey, const Move& move, int weight) {
-    std::vector<BookMove>& entries = book[positionKey];
+    std::vector<BookMove>& entries = staging[positionKey];
+    uint16_t packed = packMove(move);
     for (BookMove& existing : entries) {
-        if (existing.move.from == move.from && existing.move.to == move.to &&
-            existing.move.promotion == move.promotion) {
-            existing.weight = (weight >= 0) ? weight : existing.weight + 1;
+        if (existing.move == packed) {
+            existing.weight = (weight >= 0) ? static_cast<uint32_t>(weight) : existing.weight + 1;
             return;
         }
     }
-    entries.push_back({move, (weight >= 0) ? weight : 1});
-}
-
-// Resolves a move string (castle, coordinate, or SAN) to one of the position's
-// legal moves, so the returned move always carries correct capture/castle/
-// en-passant flags. Returns a null move (from == to) if it can't be matched.
-Move OpeningBook::parseMove(const std::string& moveStr, const Board& board) {
-    std::vector<Move> legalMoves = MoveGenerator::generateLegalMoves(board);
-
-    if (moveStr == "O-O" || moveStr == "0-0" || moveStr == "O-O-O" || moveStr == "0-0-0") {
-        bool kingSide = (moveStr == "O-O" || moveStr == "0-0");
-        for (const Move& m : legalMoves)
-            if (m.isCastle && (fileOf(m.to) == 6) == kingSide) return m;
-        return Move();
-    }
-
-    if (moveStr.length() == 4 || moveStr.length() == 5) {
-        int fromFile = moveStr[0] - 'a';
-        int fromRank = moveStr[1] - '1';
-        int toFile   = moveStr[2] - 'a';
-        int toRank   = moveStr[3] - '1';
-
-        if (fromFile >= 0 && fromFile < 8 && fromRank >= 0 && fromRank < 8 &&
-            toFile   >= 0 && toFile   < 8 && toRank   >= 0 && toRank   < 8) {
-            Square from = makeSquare(fromFile, fromRank);
-            Square to   = makeSquare(toFile,   toRank);
-
-            PieceType promotion = PieceType::NONE;
-            if (moveStr.length() == 5) {
-                switch (std::tolower(moveStr[4])) {
-                    case 'q': promotion = PieceType::QUEEN;  break;
-                    case 'r': promotion = PieceType::ROOK;   break;
-                    case 'b': promotion = PieceType::BISHOP; break;
-                    case 'n': promotion = PieceType::KNIGHT; break;
-                }
-            }
-            for (const Move& m : legalMoves)
-                if (m.from == from && m.to == to && m.promotion == promotion) return m;
-            return Move();
-        }
-    }
-
-    // SAN matching; normalize "e8=Q" to "e8Q" first
-    std::string san = moveStr;
-    san.erase(std::remove(san.begin(), san.end(), '='), san.end());
-
-    for (const Move& m : legalMoves)
-        if (moveToString(m) == san) return m;
-    for (const Move& m : legalMoves)
-        if (moveToAlgebraic(m, board) == san) return m;
-
-    // Disambiguated piece moves (Nbd2, R1a3, Qh4e1): compare against the plain
-    // algebraic form with the from-file/rank hint(s) inserted after the piece.
-    for (const Move& m : legalMoves) {
-        std::string alg = moveToAlgebraic(m, board);
-        if (alg.empty() || !std::isupper(static_cast<unsigned char>(alg[0]))) continue;
-        std::string piece(1, alg[0]);
-        std::string tail = alg.substr(1);
-        std::string f(1, static_cast<char>('a' + fileOf(m.from)));
-        std::string r(1, static_cast<char>('1' + rankOf(m.from)));
-        if (san == piece + f + tail || san == piece + r + tail ||
-            san == piece + f + r + tail) return m;
-    }
-
-    return Move();
-}
-
-std::string OpeningBook::moveToString(const Move& move) {
-    if (move.isCastle)
-        return (move.to == G1 || move.to == G8) ? "O-O" : "O-O-O";
-
-    std::ostringstream oss;
-    oss << static_cast<char>('a' + fileOf(move.from)) << (rankOf(move.from) + 1)
-        << static_cast<char>('a' + fileOf(move.to))   << (rankOf(move.to)   + 1);
-
-    if (move.promotion != PieceType::NONE) {
-        switch (move.promotion) {
-            case PieceType::QUEEN:  oss << "Q"; break;
-            case PieceType::ROOK:   oss << "R"; break;
-            case PieceType::BISHOP: oss << "B"; break;
-            case PieceType::KNIGHT: oss << "N"; break;
-            default: break;
-        }
-    }
-    return oss.str();
+    entries.push_back({(weight >= 0) ? static_cast<uint32_t>(weight) : 1u, packed});
 }
 
-std::string OpeningBook::moveToAlgebraic(const Move& move, const Board& board) {
-    if (move.isCastle)
-        return (move.to == G1 || move.to == G8) ? "O-O" : "O-O-O";
-
-    Piece piece = board.pieceAt(move.from);
-    if (piece.isEmpty()) return "";
-
-    std::ostringstream oss;
-    switch (piece.type) {
-        case PieceType::KNIGHT: oss << "N"; break;
-        case PieceType::BISHOP: oss << "B"; break;
-        case PieceType::ROOK:   oss << "R"; break;
-        case PieceType::QUEEN:  oss << "Q"; break;
-        case PieceType::KING:   oss << "K"; break;
-        default: break;
+Move OpeningBook::getRandomMove(const Board& board) {
+    if (polyglot.isOpen()) {
+        Move move = polyglot.pick(board, rng);
+        if (move.from != move.to) return move;
     }
-
-    bool isCapture = move.isCapture || move.isEnPassant || !board.pieceAt(move.to).isEmpty();
-    if (isCapture && piece.type == PieceType::PAWN)
-        oss << static_cast<char>('a' + fileOf(move.from));
-    if (isCapture) oss << "x";
-
-    oss << static_cast<char>('a' + fileOf(move.to)) << (rankOf(move.to) + 1);
-
-    if (move.promotion != PieceType::NONE) {
-        switch (move.promotion) {
-            case PieceType::QUEEN:  oss << "Q"; break;
-            case PieceType::ROOK:   oss << "R"; break;
-            case PieceType::BISHOP: oss << "B"; break;
-            case PieceType::KNIGHT: oss << "N"; break;
-            default: break;
-        }
+    if (view.positions == 0) return Move();
+
+    // Zobrist keys are uniformly distributed, so interpolating the key's
+    // position in the range finds it in a few probes rather than log2(n)
+    uint64_t key = board.getHash();
+    size_t lo = 0, hi = view.positions - 1;
+    while (lo < hi && key >= view.keys[lo] && key <= view.keys[hi]) {
+        uint64_t span = view.keys[hi] - view.keys[lo];
+        size_t mid = lo;
+        if (span) mid += static_cast<size_t>(
+            static_cast<double>(key - view.keys[lo]) / static_cast<double>(span) * (hi - lo));
+        if (mid > hi) mid = hi;
+        if (view.keys[mid] < key)      lo = mid + 1;
+        else if (view.keys[mid] > key) hi = mid ? mid - 1 : 0;
+        else { lo = hi = mid; }
     }
-    return oss.str();
-}
+    if (lo >= view.positions || view.keys[lo] != key) return Move();
 
-Move OpeningBook::getRandomMove(const Board& board) {
-    auto it = book.find(board.getHash());
-    if (it == book.end() || it->second.empty()) return Move();
+    const BookMove* first = view.moves + view.offsets[lo];
+    const BookMove* last  = view.moves + view.offsets[lo + 1];
+    if (first == last) return Move();
 
-    int totalWeight = 0;
-    for (const BookMove& m : it->second) totalWeight += m.weight;
-    if (totalWeight <= 0) {  // all weights zero: fall back to a uniform pick
-        std::uniform_int_distribution<size_t> u(0, it->second.size() - 1);
-        return it->second[u(rng)].move;
+    uint64_t totalWeight = 0;
+    for (const BookMove* m = first; m != last; ++m) totalWeight += m->weight;
+    if (totalWeight == 0) {  // all weights zero: fall back to a uniform pick
+        std::uniform_int_distribution<size_t> u(0, static_cast<size_t>(last - first) - 1);
+        return unpackMove(first[u(rng)].move);
     }
 
-    std::uniform_int_distribution<int> dist(1, totalWeight);
-    int roll = dist(rng);
-    for (const BookMove& m : it->second) {
-        roll -= m.weight;
-        if (roll <= 0) return m.move;
+    std::uniform_int_distribution<uint64_t> dist(1, totalWeight);
+    uint64_t roll = dist(rng);
+    for (const BookMove* m = first; m != last; ++m) {
+        if (roll <= m->weight) return unpackMove(m->move);
+        roll -= m->weight;
     }
-    return it->second.back().move;
+    return unpackMove((last - 1)->move);
 }
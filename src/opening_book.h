@@ -3,9 +3,12 @@
 
 #include "types.h"
 #include "board.h"
-#include <iosfwd>
+#include "eco_book.h"
+#include "polyglot.h"
+#include "pgn.h"
 #include <vector>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <random>
 
@@ -16,32 +19,51 @@ public:
 
     bool loadFromFile(const std::string& filename);
     bool loadEmbedded();  // book compiled into the binary (eco_book.cpp)
+    // A Polyglot .bin book consulted before the PGN/embedded book; an empty
+    // path closes it. False if the file cannot be used; the old book stays.
+    bool loadPolyglot(const std::string& filename);
+    size_t polyglotEntries() const { return polyglot.size(); }
+
+    // The loaded book, flat: keys ascending, position i's moves at
+    // moves[offsets[i]] up to moves[offsets[i + 1]], heaviest first
+    struct Table {
+        const uint64_t* keys = nullptr;
+        const uint32_t* offsets = nullptr;
+        const BookMove* moves = nullptr;
+        size_t positions = 0;
+    };
+    const Table& table() const { return view; }
+
+    static uint16_t packMove(const Move& move);
+    static Move unpackMove(uint16_t packed);
 
     // Random choice among the position's book moves, weighted by how many
-    // book lines continue through each move (mainlines are preferred)
+    // book lines continue through each move (mainlines are preferred). A
+    // Polyglot book, when open, is asked first.
     Move getRandomMove(const Board& board);
 
 private:
-    struct BookMove {
-        Move move;
-        int weight;
-    };
-
     // Positions are keyed by the board's zobrist hash, so transpositions
-    // (same position via a different move order) share book entries.
-    std::unordered_map<uint64_t, std::vector<BookMove>> book;
+    // (same position via a different move order) share book entries. The
+    // map only exists while a PGN is being parsed; finalize() packs it
+    // into the flat arrays below and frees it.
+    std::unordered_map<uint64_t, std::vector<BookMove>> staging;
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> offsets;
+    std::vector<BookMove> moves;
+    Table view;  // over the vectors above, or over the embedded tables
+    PolyglotBook polyglot;
     std::mt19937 rng;
 
-    bool parseStream(std::istream& file, const std::string& sourceName);
-    Move parseMove(const std::string& moveStr, const Board& board);
-    std::string moveToString(const Move& move);
-    std::string moveToAlgebraic(const Move& move, const Board& board);
+    void finalize();
+    // Reads PGN games in place; data may point into a file mapping and is
+    // not referenced after the call returns.
+    bool parseBuffer(std::string_view data, const std::string& sourceName);
     // weight < 0: increment the existing count by 1 (legacy named-opening
     // counting); weight >= 0: set the count explicitly (e.g. a real game
     // count from a master database).
     void addMoveToBook(uint64_t positionKey, const Move& move, int weight = -1);
-    // Each pair is (move token, explicit weight or -1)
-    void processGame(const std::vector<std::pair<std::string, int>>& moves);
+    void processGame(const PgnGame& game);
 };
 
 #endif // OPENING_BOOK_H
@@ -0,0 +1,121 @@
+#include "options.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace {
+    std::string lower(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return s;
+    }
+
+    bool parseInt(const std::string& text, long long& out) {
+        if (text.empty()) return false;
+        char* end = nullptr;
+        out = std::strtoll(text.c_str(), &end, 10);
+        return *end == '\0';
+    }
+}
+
+int OptionRegistry::Option::asInt() const {
+    return std::atoi(value.c_str());
+}
+
+void OptionRegistry::addCheck(const std::string& name, bool defaultValue, Callback onChange) {
+    std::string v = defaultValue ? "true" : "false";
+    options.push_back({name, Type::Check, v, 0, 0, v, std::move(onChange)});
+}
+
+void OptionRegistry::addSpin(const std::string& name, int defaultValue, int min, int max,
+                             Callback onChange) {
+    std::string v = std::to_string(defaultValue);
+    options.push_back({name, Type::Spin, v, min, max, v, std::move(onChange)});
+}
+
+void OptionRegistry::addString(const std::string& name, const std::string& defaultValue,
+                               Callback onChange) {
+    options.push_back({name, Type::String, defaultValue, 0, 0, defaultValue, std::move(onChange)});
+}
+
+void OptionRegistry::addButton(const std::string& name, Callback onChange) {
+    options.push_back({name, Type::Button, "", 0, 0, "", std::move(onChange)});
+}
+
+std::vector<std::string> OptionRegistry::describe() const {
+    std::vector<std::string> lines;
+    for (const Option& o : options) {
+        std::string line = "option name " + o.name + " type ";
+        switch (o.type) {
+            case Type::Check:
+                line += "check default " + o.defaultValue;
+                break;
+            case Type::Spin:
+                line += "spin default " + o.defaultValue + " min " + std::to_string(o.min) +
+                        " max " + std::to_string(o.max);
+                break;
+            case Type::String:
+                line += "string default " + (o.defaultValue.empty() ? "<empty>" : o.defaultValue);
+                break;
+            case Type::Button:
+                line += "button";
+                break;
+        }
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+int OptionRegistry::indexOf(const std::string& name) const {
+    std::string key = lower(name);
+    for (size_t i = 0; i < options.size(); i++)
+        if (lower(options[i].name) == key) return static_cast<int>(i);
+    return -1;
+}
+
+const OptionRegistry::Option* OptionRegistry::find(const std::string& name) const {
+    int i = indexOf(name);
+    return i < 0 ? nullptr : &options[i];
+}
+
+bool OptionRegistry::set(const std::string& name, const std::string& value, std::string& error) {
+    int index = indexOf(name);
+    if (index < 0) {
+        error = "unknown option " + name;
+        return false;
+    }
+    Option* option = &options[index];
+    std::string previous = option->value;
+
+    switch (option->type) {
+        case Type::Check: {
+            std::string v = lower(value);
+            if (v != "true" && v != "false") {
+                error = option->name + " expects true or false, not " + value;
+                return false;
+            }
+            option->value = v;
+            break;
+        }
+        case Type::Spin: {
+            long long v = 0;
+            if (!parseInt(value, v)) {
+                error = option->name + " expects a number, not " + value;
+                return false;
+            }
+            v = std::clamp<long long>(v, option->min, option->max);
+            option->value = std::to_string(v);
+            break;
+        }
+        case Type::String:
+            option->value = value == "<empty>" ? "" : value;
+            break;
+        case Type::Button:
+            break;
+    }
+    if (option->onChange && !option->onChange(*option, error)) {
+        option->value = previous;
+        return false;
+    }
+    return true;
+}
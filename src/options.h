@@ -0,0 +1,59 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Typed UCI options: what the "uci" reply advertises and "setoption" sets.
+//
+// Each option has a UCI type (check, spin, string, button), a default and,
+// for spins, a range. Setting one validates the value and runs the option's
+// callback, which applies it to the engine; the value is kept only if the
+// callback accepts it. Names are matched case-insensitively, as the
+// protocol requires.
+class OptionRegistry {
+public:
+    enum class Type { Check, Spin, String, Button };
+
+    struct Option {
+        std::string name;
+        Type type;
+        std::string defaultValue;
+        int min = 0, max = 0;  // spin only
+        std::string value;     // current value; "<empty>" is stored as ""
+        // Sees the new value in value. False, with a reason in error, if it
+        // cannot be applied; the engine must then be left as it was.
+        std::function<bool(const Option&, std::string& error)> onChange;
+
+        int asInt() const;
+        bool asBool() const { return value == "true"; }
+    };
+
+    using Callback = std::function<bool(const Option&, std::string& error)>;
+
+    void addCheck(const std::string& name, bool defaultValue, Callback onChange = nullptr);
+    void addSpin(const std::string& name, int defaultValue, int min, int max,
+                 Callback onChange = nullptr);
+    void addString(const std::string& name, const std::string& defaultValue,
+                   Callback onChange = nullptr);
+    void addButton(const std::string& name, Callback onChange);
+
+    // The "option name ..." lines of the uci reply, in registration order
+    std::vector<std::string> describe() const;
+
+    // Validates the value and runs the callback, keeping the value if the
+    // callback accepts it. Spin values outside the range are clamped. False,
+    // with a reason in error, for an unknown option, a value of the wrong
+    // type, or one the callback rejected (the old value then stays).
+    bool set(const std::string& name, const std::string& value, std::string& error);
+
+    const Option* find(const std::string& name) const;
+
+private:
+    std::vector<Option> options;
+
+    int indexOf(const std::string& name) const;  // -1 if unknown
+};
+
+#endif // OPTIONS_H
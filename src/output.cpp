@@ -0,0 +1,66 @@
+#include "output.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    // Only serializes the rare line that needs more than one write() call
+    std::mutex writeMutex;
+
+    void writeAll(const char* data, std::size_t size) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        while (size > 0) {
+#ifdef _WIN32
+            int n = _write(1, data, static_cast<unsigned>(size));
+#else
+            ssize_t n = ::write(STDOUT_FILENO, data, size);
+#endif
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return;  // stdout is gone; nothing useful left to do
+            }
+            data += n;
+            size -= static_cast<std::size_t>(n);
+        }
+    }
+}
+
+OutputLine& OutputLine::operator<<(std::string_view text) {
+    std::size_t n = std::min(text.size(), CAPACITY - 1 - length);
+    std::memcpy(buffer + length, text.data(), n);
+    length += n;
+    return *this;
+}
+
+OutputLine& OutputLine::operator<<(char c) {
+    if (length < CAPACITY - 1) buffer[length++] = c;
+    return *this;
+}
+
+OutputLine& OutputLine::operator<<(const Move& move) {
+    char text[5] = {
+        static_cast<char>('a' + fileOf(move.from)), static_cast<char>('1' + rankOf(move.from)),
+        static_cast<char>('a' + fileOf(move.to)),   static_cast<char>('1' + rankOf(move.to)), 0};
+    std::size_t n = 4;
+    switch (move.promotion) {
+        case PieceType::KNIGHT: text[n++] = 'n'; break;
+        case PieceType::BISHOP: text[n++] = 'b'; break;
+        case PieceType::ROOK:   text[n++] = 'r'; break;
+        case PieceType::QUEEN:  text[n++] = 'q'; break;
+        default: break;
+    }
+    return *this << std::string_view(text, n);
+}
+
+void OutputLine::send() {
+    buffer[length++] = '\n';
+    writeAll(buffer, length);
+    length = 0;
+}
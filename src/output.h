@@ -0,0 +1,45 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include "types.h"
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// One line of engine output to stdout (info, bestmove, readyok, ...).
+//
+// The text is formatted into a fixed buffer on the stack - numbers with
+// std::to_chars, no iostream or locale machinery - and send() hands the
+// whole line to the OS in a single write(). Lines from the command loop and
+// the search thread therefore never interleave, and each costs one syscall
+// instead of one flush per << of an unbuffered std::cout. A line longer than
+// the buffer is cut short.
+class OutputLine {
+public:
+    static constexpr std::size_t CAPACITY = 4096;
+
+    OutputLine& operator<<(std::string_view text);
+    OutputLine& operator<<(const char* text) { return *this << std::string_view(text); }
+    OutputLine& operator<<(const std::string& text) { return *this << std::string_view(text); }
+    OutputLine& operator<<(char c);
+    OutputLine& operator<<(const Move& move);  // UCI coordinates
+
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+    OutputLine& operator<<(T value) {
+        char* end = buffer + CAPACITY - 1;  // room for the newline
+        auto result = std::to_chars(buffer + length, end, value);
+        if (result.ec == std::errc()) length = static_cast<std::size_t>(result.ptr - buffer);
+        return *this;
+    }
+
+    // Terminates the line and writes it; the object is empty afterwards
+    void send();
+
+private:
+    char buffer[CAPACITY];
+    std::size_t length = 0;
+};
+
+#endif // OUTPUT_H
@@ -0,0 +1,49 @@
+#include "packed_position.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+PackedPosition PackedPosition::pack(const Board& board, int score, int result) {
+    PackedPosition p;
+    std::memset(&p, 0, sizeof(p));
+    p.occupancy = board.getAllPieces();
+
+    int n = 0;
+    for (Bitboard bb = p.occupancy; bb; bb &= bb - 1, n++) {
+        Piece piece = board.pieceAt(firstSquare(bb));
+        int code = static_cast<int>(piece.type) + (piece.color == Color::BLACK ? 6 : 0);
+        p.pieces[n / 2] |= static_cast<uint8_t>(code << (4 * (n & 1)));
+    }
+
+    p.score  = static_cast<int16_t>(std::max(-32767, std::min(32767, score)));
+    p.result = static_cast<int8_t>(result);
+    p.flags  = (board.getSideToMove() == Color::BLACK ? 1 : 0) |
+               (board.canCastle(Color::WHITE, true)  ? 2 : 0) |
+               (board.canCastle(Color::WHITE, false) ? 4 : 0) |
+               (board.canCastle(Color::BLACK, true)  ? 8 : 0) |
+               (board.canCastle(Color::BLACK, false) ? 16 : 0);
+    p.enPassant      = board.getEnPassantSquare();
+    p.halfMoveClock  = static_cast<uint8_t>(std::min(board.getHalfMoveClock(), 255));
+    p.fullMoveNumber = static_cast<uint16_t>(std::min(board.getFullMoveNumber(), 65535));
+    return p;
+}
+
+bool PackedPosition::unpack(Board& board) const {
+    std::array<Piece, 64> placement;
+    int n = 0;
+    for (Bitboard bb = occupancy; bb && n < 32; bb &= bb - 1, n++) {
+        int code = (pieces[n / 2] >> (4 * (n & 1))) & 15;
+        if (code >= 12) return false;
+        placement[firstSquare(bb)] = Piece(static_cast<PieceType>(code % 6),
+                                           code < 6 ? Color::WHITE : Color::BLACK);
+    }
+    board.setPosition(placement, (flags & 1) ? Color::BLACK : Color::WHITE, (flags >> 1) & 15,
+                      enPassant, halfMoveClock, fullMoveNumber);
+    return true;
+}
+
+std::string PackedPosition::toFEN() const {
+    Board board;
+    unpack(board);
+    return board.toFEN();
+}
@@ -0,0 +1,34 @@
+#ifndef PACKED_POSITION_H
+#define PACKED_POSITION_H
+
+#include "types.h"
+#include "board.h"
+#include <cstdint>
+#include <string>
+
+// A position with its search score and game result in 32 bytes, the record
+// format of training data (chess_engine datagen). Records are written
+// as-is, little-endian, with no header; a file is just an array of them.
+//
+// The pieces are listed in square order (a1 first) for each set bit of
+// occupancy, one nibble each (low nibble first): white pawn..king = 0-5,
+// black pawn..king = 6-11. A position has at most 32 pieces, so 16 bytes.
+struct PackedPosition {
+    uint64_t occupancy;
+    uint8_t  pieces[16];
+    int16_t  score;          // centipawns, white-relative
+    int8_t   result;         // 1 white won, 0 draw, -1 black won
+    uint8_t  flags;          // bit 0: black to move; bits 1-4: castling KQkq
+    uint8_t  enPassant;      // square, 64 = none
+    uint8_t  halfMoveClock;
+    uint16_t fullMoveNumber;
+
+    static PackedPosition pack(const Board& board, int score, int result);
+    // False if the record holds a piece code outside 0-11
+    bool unpack(Board& board) const;
+    std::string toFEN() const;
+};
+
+static_assert(sizeof(PackedPosition) == 32, "PackedPosition must stay 32 bytes");
+
+#endif // PACKED_POSITION_H
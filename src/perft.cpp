@@ -0,0 +1,119 @@
+#include "perft.h"
+#include "movegen.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace {
+    // Shared between threads without locks: the key is stored XOR-ed with
+    // the count, so a torn entry (key from one write, count from another)
+    // fails the check instead of returning a wrong count.
+    struct PerftEntry {
+        std::atomic<uint64_t> check{0};
+        std::atomic<uint64_t> count{0};
+    };
+
+    class PerftTable {
+    public:
+        explicit PerftTable(int megabytes) {
+            size_t bytes = static_cast<size_t>(megabytes) << 20;
+            size_t n = 1;
+            while (n * 2 * sizeof(PerftEntry) <= bytes) n *= 2;
+            entries.reset(new PerftEntry[n]);
+            mask = n - 1;
+        }
+
+        bool probe(uint64_t key, uint64_t& count) const {
+            const PerftEntry& e = entries[key & mask];
+            uint64_t c = e.count.load(std::memory_order_relaxed);
+            if ((e.check.load(std::memory_order_relaxed) ^ c) != key) return false;
+            count = c;
+            return true;
+        }
+
+        void store(uint64_t key, uint64_t count) {
+            PerftEntry& e = entries[key & mask];
+            e.count.store(count, std::memory_order_relaxed);
+            e.check.store(key ^ count, std::memory_order_relaxed);
+        }
+
+    private:
+        std::unique_ptr<PerftEntry[]> entries;
+        size_t mask = 0;
+    };
+
+    // Distinct key per remaining depth for the same position
+    uint64_t perftKey(const Board& board, int depth) {
+        return board.getHash() ^ (0x9E3779B97F4A7C15ULL * static_cast<uint64_t>(depth + 1));
+    }
+
+    bool stopped(const std::atomic<bool>* stop) {
+        return stop && stop->load(std::memory_order_relaxed);
+    }
+
+    uint64_t perft(Board& board, int depth, PerftTable* table, const std::atomic<bool>* stop) {
+        // Probe before generating, so a hit costs no move generation. The
+        // last ply is never stored: its count is the list size anyway.
+        uint64_t key = 0, nodes = 0;
+        if (table && depth > 1) {
+            key = perftKey(board, depth);
+            if (table->probe(key, nodes)) return nodes;
+        }
+
+        MoveList moves;
+        MoveGenerator::generateLegalMoves(board, moves);
+        if (depth == 1) return moves.size();  // bulk count the last ply
+
+        for (const Move& m : moves) {
+            board.makeMove(m);
+            nodes += perft(board, depth - 1, table, stop);
+            board.unmakeMove(m);
+            // Checked above the bulk-counted plies only, where one relaxed
+            // load is lost in the work per move. A cut subtree is not cached.
+            if (depth > 2 && stopped(stop)) return nodes;
+        }
+
+        if (table) table->store(key, nodes);
+        return nodes;
+    }
+}
+
+std::vector<std::pair<Move, uint64_t>> Perft::divide(const Board& board, int depth,
+                                                     int threads, int hashMB,
+                                                     const std::atomic<bool>* stop) {
+    std::vector<std::pair<Move, uint64_t>> results;
+    if (depth < 1) return results;
+    for (const Move& m : MoveGenerator::generateLegalMoves(board))
+        results.emplace_back(m, depth == 1 ? 1 : 0);
+    if (depth == 1) return results;
+
+    std::unique_ptr<PerftTable> table;
+    if (hashMB > 0) table.reset(new PerftTable(hashMB));
+
+    // Each thread takes the next unclaimed root move
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        Board b = board;
+        for (size_t i = next++; i < results.size() && !stopped(stop); i = next++) {
+            b.makeMove(results[i].first);
+            results[i].second = perft(b, depth - 1, table.get(), stop);
+            b.unmakeMove(results[i].first);
+        }
+    };
+
+    threads = std::max(1, std::min<int>(threads, static_cast<int>(results.size())));
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+    return results;
+}
+
+uint64_t Perft::count(const Board& board, int depth, int threads, int hashMB,
+                      const std::atomic<bool>* stop) {
+    if (depth < 1) return 1;
+    uint64_t total = 0;
+    for (const auto& entry : divide(board, depth, threads, hashMB, stop)) total += entry.second;
+    return total;
+}
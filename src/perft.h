@@ -0,0 +1,31 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "types.h"
+#include "board.h"
+#include <atomic>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Leaf-node counting over the legal move tree, for validating move
+// generation against published totals.
+//
+// The last ply is bulk counted (the size of the legal move list, without
+// making the moves), subtrees can be cached in a hash table keyed by
+// position and remaining depth, and root moves are shared out between
+// threads, each with its own copy of the board.
+class Perft {
+public:
+    // hashMB = 0 disables the hash table. Once *stop is set the threads
+    // give up, and the counts returned are incomplete.
+    static uint64_t count(const Board& board, int depth, int threads = 1, int hashMB = 0,
+                          const std::atomic<bool>* stop = nullptr);
+
+    // Leaf count below each root move, in generation order ("divide")
+    static std::vector<std::pair<Move, uint64_t>> divide(const Board& board, int depth,
+                                                         int threads = 1, int hashMB = 0,
+                                                         const std::atomic<bool>* stop = nullptr);
+};
+
+#endif // PERFT_H
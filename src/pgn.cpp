@@ -0,0 +1,288 @@
+#include "pgn.h"
+#include "movegen.h"
+#include <cstdlib>
+
+namespace {
+    bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+    // Characters that end a movetext token besides whitespace
+    bool isDelimiter(char c) {
+        return isSpace(c) || c == '(' || c == ')' || c == '{' || c == '}' || c == ';' || c == '$';
+    }
+    bool isFile(char c) { return c >= 'a' && c <= 'h'; }
+    bool isRank(char c) { return c >= '1' && c <= '8'; }
+    bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    PieceType pieceFromLetter(char c) {
+        switch (c) {
+            case 'N': return PieceType::KNIGHT;
+            case 'B': return PieceType::BISHOP;
+            case 'R': return PieceType::ROOK;
+            case 'Q': return PieceType::QUEEN;
+            case 'K': return PieceType::KING;
+            default:  return PieceType::NONE;
+        }
+    }
+
+    PieceType promotionFromLetter(char c) {
+        switch (c) {
+            case 'N': case 'n': return PieceType::KNIGHT;
+            case 'B': case 'b': return PieceType::BISHOP;
+            case 'R': case 'r': return PieceType::ROOK;
+            case 'Q': case 'q': return PieceType::QUEEN;
+            default:            return PieceType::NONE;
+        }
+    }
+
+    // Our pieces of the given type that attack `to` (pawns: diagonally)
+    Bitboard attackersOf(const Board& board, PieceType type, Color us, Square to) {
+        Bitboard own = board.getPieceBitboard(type, us);
+        Bitboard occupied = board.getAllPieces();
+        switch (type) {
+            case PieceType::PAWN:   return MoveGenerator::getPawnAttacks(to, ~us) & own;
+            case PieceType::KNIGHT: return MoveGenerator::getKnightAttacks(to) & own;
+            case PieceType::BISHOP: return MoveGenerator::getBishopAttacks(to, occupied) & own;
+            case PieceType::ROOK:   return MoveGenerator::getRookAttacks(to, occupied) & own;
+            case PieceType::QUEEN:  return MoveGenerator::getQueenAttacks(to, occupied) & own;
+            case PieceType::KING:   return MoveGenerator::getKingAttacks(to) & own;
+            default:                return EMPTY_BOARD;
+        }
+    }
+
+    // Whether our king is safe after the piece on `from` moves to `to`,
+    // removing the enemy piece on capturedSquare (64 = none)
+    bool kingSafeAfter(const Board& board, Color us, Square from, Square to, Square capturedSquare) {
+        Bitboard occupied = setBit(clearBit(board.getAllPieces(), from), to);
+        Bitboard enemy = us == Color::WHITE ? board.getBlackPieces() : board.getWhitePieces();
+        if (capturedSquare < 64) {
+            if (capturedSquare != to) occupied = clearBit(occupied, capturedSquare);
+            enemy = clearBit(enemy, capturedSquare);
+        }
+        Square king = board.pieceAt(from).type == PieceType::KING ? to : board.findKing(us);
+        return !(MoveGenerator::attackersTo(board, king, occupied) & enemy);
+    }
+
+    Move castle(const Board& board, Color us, bool kingSide) {
+        Square king = us == Color::WHITE ? E1 : E8;
+        Square rook = kingSide ? king + 3 : king - 4;
+        int step = kingSide ? 1 : -1;
+        if (!board.canCastle(us, kingSide) ||
+            board.pieceAt(king).type != PieceType::KING || board.pieceAt(king).color != us ||
+            board.pieceAt(rook).type != PieceType::ROOK || board.pieceAt(rook).color != us)
+            return Move();
+        for (int sq = king + step; sq != rook; sq += step)
+            if (getBit(board.getAllPieces(), static_cast<Square>(sq))) return Move();
+        Color them = ~us;
+        if (board.isInCheck(us) ||
+            board.isSquareAttacked(static_cast<Square>(king + step), them) ||
+            board.isSquareAttacked(static_cast<Square>(king + 2 * step), them))
+            return Move();
+        Move move(king, static_cast<Square>(king + 2 * step));
+        move.isCastle = true;
+        return move;
+    }
+}
+
+std::string_view PgnGame::tag(std::string_view name) const {
+    for (const auto& t : tags)
+        if (t.first == name) return t.second;
+    return {};
+}
+
+bool PgnReader::next(PgnGame& game) {
+    game.clear();
+    bool inMoves = false;   // movetext has started
+    bool lineStart = true;  // only whitespace so far on this line
+    int depth = 0;          // variation nesting
+
+    while (pos < data.size()) {
+        char c = data[pos];
+
+        if (c == '\n') {
+            // A blank line after movetext ends a game that has no result token
+            if (lineStart && inMoves && depth == 0) { pos++; return true; }
+            lineStart = true;
+            pos++;
+            continue;
+        }
+        if (isSpace(c)) { pos++; continue; }
+
+        if (lineStart && (c == '[' || c == '%') && depth == 0) {
+            if (c == '[' && inMoves) return true;  // next game's tags; leave them unread
+            size_t eol = data.find('\n', pos);
+            if (eol == std::string_view::npos) eol = data.size();
+            std::string_view line = data.substr(pos, eol - pos);
+            pos = eol;
+            if (c == '%') continue;  // escaped line
+
+            // [Name "Value"]
+            size_t nameEnd = 1;
+            while (nameEnd < line.size() && !isSpace(line[nameEnd]) && line[nameEnd] != '"' &&
+                   line[nameEnd] != ']')
+                nameEnd++;
+            size_t open = line.find('"', nameEnd);
+            size_t close = line.rfind('"');
+            std::string_view value;
+            if (open != std::string_view::npos && close > open)
+                value = line.substr(open + 1, close - open - 1);
+            game.tags.emplace_back(line.substr(1, nameEnd - 1), value);
+            continue;
+        }
+        lineStart = false;
+
+        if (c == '{') {  // comments may span lines
+            size_t end = data.find('}', pos);
+            pos = (end == std::string_view::npos) ? data.size() : end + 1;
+            continue;
+        }
+        if (c == ';') {  // rest-of-line comment; the newline itself is kept
+            size_t end = data.find('\n', pos);
+            pos = (end == std::string_view::npos) ? data.size() : end;
+            continue;
+        }
+        if (c == '(') { depth++; pos++; continue; }
+        if (c == ')') { if (depth > 0) depth--; pos++; continue; }
+
+        size_t start = pos++;
+        while (pos < data.size() && !isDelimiter(data[pos])) pos++;
+        std::string_view token = data.substr(start, pos - start);
+        inMoves = true;
+
+        if (c == '$') {
+            // A NAG belongs to the move before it; keep the first one
+            int value = 0;
+            for (size_t i = 1; i < token.size() && isDigit(token[i]) && value < 100000000; i++)
+                value = value * 10 + (token[i] - '0');
+            if (depth == 0 && token.size() > 1 && !game.moves.empty() && game.moves.back().nag < 0)
+                game.moves.back().nag = value;
+            continue;
+        }
+        if (depth > 0) continue;
+
+        if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+            game.result = token;
+            return true;
+        }
+        // Move numbers, possibly glued to the move ("12.", "12...", "1.e4")
+        size_t skip = 0;
+        while (skip < token.size() && isDigit(token[skip])) skip++;
+        if (skip < token.size() && token[skip] == '.') {
+            while (skip < token.size() && token[skip] == '.') skip++;
+            token.remove_prefix(skip);
+        } else if (skip == token.size()) {
+            continue;  // a bare number
+        }
+        while (!token.empty() && token[0] == '.') token.remove_prefix(1);
+        if (!token.empty()) game.moves.push_back({token, -1});
+    }
+    return inMoves || !game.tags.empty();
+}
+
+size_t PgnReader::nextGameStart(std::string_view data, size_t from) {
+    if (from == 0) return 0;
+    for (size_t i = data.find("\n[", from - 1); i != std::string_view::npos;
+         i = data.find("\n[", i + 1)) {
+        // The line before must be blank (whitespace only)
+        size_t j = i;
+        while (j > 0 && (data[j - 1] == ' ' || data[j - 1] == '\t' || data[j - 1] == '\r')) j--;
+        if (j == 0 || data[j - 1] == '\n') return i + 1;
+    }
+    return data.size();
+}
+
+Move PgnReader::resolveMove(const Board& board, std::string_view text) {
+    while (!text.empty() && (text.back() == '+' || text.back() == '#' ||
+                             text.back() == '!' || text.back() == '?'))
+        text.remove_suffix(1);
+
+    Color us = board.getSideToMove();
+    if (text == "O-O" || text == "0-0") return castle(board, us, true);
+    if (text == "O-O-O" || text == "0-0-0") return castle(board, us, false);
+    if (text.size() < 2) return Move();
+
+    PieceType type = PieceType::PAWN;
+    PieceType promotion = PieceType::NONE;
+    Bitboard fromMask = FULL_BOARD;
+    Square to;
+
+    bool coordinate = (text.size() == 4 || text.size() == 5) &&
+                      isFile(text[0]) && isRank(text[1]) && isFile(text[2]) && isRank(text[3]);
+    if (coordinate) {
+        Square from = makeSquare(text[0] - 'a', text[1] - '1');
+        to = makeSquare(text[2] - 'a', text[3] - '1');
+        Piece piece = board.pieceAt(from);
+        if (piece.isEmpty() || piece.color != us) return Move();
+        type = piece.type;
+        if (type == PieceType::KING && std::abs(fileOf(to) - fileOf(from)) == 2)
+            return castle(board, us, fileOf(to) == 6);
+        if (text.size() == 5 && (promotion = promotionFromLetter(text[4])) == PieceType::NONE)
+            return Move();
+        fromMask = setBit(EMPTY_BOARD, from);
+    } else {
+        size_t i = 0, end = text.size();
+        if (pieceFromLetter(text[0]) != PieceType::NONE) {
+            type = pieceFromLetter(text[0]);
+            i = 1;
+        } else if (!isRank(text[end - 1])) {  // e8=Q or e8Q
+            if ((promotion = promotionFromLetter(text[end - 1])) == PieceType::NONE) return Move();
+            end--;
+            if (end > i && text[end - 1] == '=') end--;
+        }
+        if (end < i + 2 || !isFile(text[end - 2]) || !isRank(text[end - 1])) return Move();
+        to = makeSquare(text[end - 2] - 'a', text[end - 1] - '1');
+
+        // Disambiguation (file, rank or both) and capture marks
+        for (size_t k = i; k < end - 2; k++) {
+            char c = text[k];
+            if (isFile(c))      fromMask &= FILE_A << (c - 'a');
+            else if (isRank(c)) fromMask &= RANK_1 << (8 * (c - '1'));
+            else if (c != 'x' && c != ':' && c != '-') return Move();
+        }
+    }
+
+    Bitboard own   = us == Color::WHITE ? board.getWhitePieces() : board.getBlackPieces();
+    Bitboard enemy = us == Color::WHITE ? board.getBlackPieces() : board.getWhitePieces();
+    if (getBit(own, to)) return Move();
+    bool enPassant = type == PieceType::PAWN && to == board.getEnPassantSquare();
+    bool capture = getBit(enemy, to) || enPassant;
+
+    Bitboard candidates;
+    if (type == PieceType::PAWN) {
+        if (capture) {
+            candidates = attackersOf(board, type, us, to);
+        } else {
+            // A push: the pawn is one square behind, or two from its home rank
+            Bitboard pawns = board.getPieceBitboard(PieceType::PAWN, us);
+            int back = us == Color::WHITE ? -8 : 8;
+            int one = to + back, two = one + back;
+            int doubleRank = us == Color::WHITE ? 3 : 4;
+            candidates = EMPTY_BOARD;
+            if (one >= 0 && one < 64 && getBit(pawns, static_cast<Square>(one)))
+                candidates = setBit(EMPTY_BOARD, static_cast<Square>(one));
+            else if (rankOf(to) == doubleRank && !getBit(board.getAllPieces(), static_cast<Square>(one)) &&
+                     getBit(pawns, static_cast<Square>(two)))
+                candidates = setBit(EMPTY_BOARD, static_cast<Square>(two));
+        }
+        bool lastRank = rankOf(to) == (us == Color::WHITE ? 7 : 0);
+        if (lastRank != (promotion != PieceType::NONE)) return Move();
+    } else {
+        if (promotion != PieceType::NONE) return Move();
+        candidates = attackersOf(board, type, us, to);
+    }
+    candidates &= fromMask;
+
+    Square capturedSquare = 64;
+    if (enPassant)    capturedSquare = us == Color::WHITE ? to - 8 : to + 8;
+    else if (capture) capturedSquare = to;
+
+    while (candidates) {
+        Square from = firstSquare(candidates);
+        candidates &= candidates - 1;
+        if (!kingSafeAfter(board, us, from, to, capturedSquare)) continue;
+        Move move(from, to);
+        move.promotion = promotion;
+        move.isCapture = capture;
+        move.isEnPassant = enPassant;
+        return move;
+    }
+    return Move();
+}
@@ -0,0 +1,62 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include "types.h"
+#include "board.h"
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// One main-line move as written in the movetext, with the first numeric
+// annotation glyph ($N) that follows it, or -1 if there is none.
+struct PgnMove {
+    std::string_view text;
+    int nag = -1;
+};
+
+// A game as read by PgnReader. All views point into the reader's buffer.
+struct PgnGame {
+    std::vector<std::pair<std::string_view, std::string_view>> tags;  // name, value
+    std::vector<PgnMove> moves;  // main line only; variations and comments are skipped
+    std::string_view result;     // "1-0", "0-1", "1/2-1/2", "*", or empty if absent
+
+    // Value of the named tag, or empty. Escapes inside the value are left as is.
+    std::string_view tag(std::string_view name) const;
+    void clear() { tags.clear(); moves.clear(); result = {}; }
+};
+
+// Streaming PGN reader over an in-memory buffer, normally a MappedFile view,
+// so multi-gigabyte databases are read straight out of the page cache.
+// Tokens are sliced in place and never copied; reusing one PgnGame across
+// next() calls makes reading allocation-free once its vectors have grown.
+//
+// A game ends at its result token, at the next tag section, or at a blank
+// line after movetext (for header-less files such as hand-written books).
+class PgnReader {
+public:
+    explicit PgnReader(std::string_view data) : data(data) {}
+
+    // Reads the next game; false once the input is exhausted
+    bool next(PgnGame& game);
+
+    // Bytes consumed so far
+    size_t offset() const { return pos; }
+
+    // Offset of the first game at or after `from` that opens with a tag
+    // section (a '[' line after a blank line), or data.size() if there is
+    // none. Splitting a file at these offsets gives shards that can be
+    // read independently.
+    static size_t nextGameStart(std::string_view data, size_t from);
+
+    // The legal move a SAN (Nf3, exd6, O-O, e8=Q+, Ng1f3) or coordinate
+    // (g1f3, e7e8q) token stands for, or a null move (from == to). Pieces
+    // that can reach the target are found from attack sets and pins are
+    // checked directly, so no move list is generated and no strings built.
+    static Move resolveMove(const Board& board, std::string_view text);
+
+private:
+    std::string_view data;
+    size_t pos = 0;
+};
+
+#endif // PGN_H
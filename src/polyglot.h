@@ -0,0 +1,40 @@
+#ifndef POLYGLOT_H
+#define POLYGLOT_H
+
+#include "types.h"
+#include "board.h"
+#include "mapped_file.h"
+#include <cstdint>
+#include <random>
+#include <string>
+
+// Polyglot (.bin) opening books: 16-byte big-endian entries (key, move,
+// weight, learn) sorted by the Polyglot position key.
+//
+// The file is memory-mapped and probed by binary search where it lies, so a
+// book of hundreds of megabytes costs no load time and no heap; only the
+// pages a lookup touches are read.
+class PolyglotBook {
+public:
+    // The standard Polyglot hash of a position (not the engine's zobrist key)
+    static uint64_t key(const Board& board);
+    // A legal move in the entry encoding (castling as king takes rook)
+    static uint16_t encodeMove(const Move& move);
+
+    // False if the file is missing or is not a whole number of entries
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+    size_t size() const;  // entries
+
+    // Random choice among the position's book moves, weighted by the entry
+    // weights, resolved to a legal move; a null move (from == to) if none
+    Move pick(const Board& board, std::mt19937& rng) const;
+
+private:
+    MappedFile file;
+
+    static Move decodeMove(const Board& board, uint16_t packed);
+};
+
+#endif // POLYGLOT_H
@@ -1,323 +1,20 @@
 #include "search.h"
 #include "movegen.h"
+#include "evaluate.h"
+#include "tbprobe.h"
+#include "output.h"
 #include <algorithm>
 #include <cstdlib>
-#include <iostream>
 #include <string>
 
 namespace {
-    // File mask: all squares on a given file
-    constexpr Bitboard fileBB(int file) { return 0x0101010101010101ULL << file; }
-
-    // All squares strictly above rank r
-    constexpr Bitboard ranksAbove(int r) {
-        return (r < 7) ? ~((1ULL << ((r + 1) * 8)) - 1) : 0ULL;
-    }
-
-    // All squares strictly below rank r
-    constexpr Bitboard ranksBelow(int r) {
-        return (r > 0) ? ((1ULL << (r * 8)) - 1) : 0ULL;
-    }
-
-    // White-relative pawn structure score, split into middlegame and endgame
-    // components (passed pawns are worth much more as material comes off).
-    void evaluatePawnStructure(const Board& board, int& mg, int& eg) {
-        Bitboard wp = board.getPieceBitboard(PieceType::PAWN, Color::WHITE);
-        Bitboard bp = board.getPieceBitboard(PieceType::PAWN, Color::BLACK);
-
-        for (int file = 0; file < 8; file++) {
-            Bitboard fb = fileBB(file);
-            int wc = popCount(wp & fb);
-            int bc = popCount(bp & fb);
-
-            // Doubled pawns
-            if (wc > 1) { mg -= 20 * (wc - 1); eg -= 20 * (wc - 1); }
-            if (bc > 1) { mg += 20 * (bc - 1); eg += 20 * (bc - 1); }
-
-            // Isolated pawns (no friendly pawn on adjacent files)
-            Bitboard adj = 0;
-            if (file > 0) adj |= fileBB(file - 1);
-            if (file < 7) adj |= fileBB(file + 1);
-
-            if (wc > 0 && !(wp & adj)) { mg -= 15 * wc; eg -= 15 * wc; }
-            if (bc > 0 && !(bp & adj)) { mg += 15 * bc; eg += 15 * bc; }
-        }
-
-        // Passed pawns
-        static const int passedMG[8] = {0, 10, 20, 35, 55,  80, 110, 0};
-        static const int passedEG[8] = {0, 20, 35, 60, 95, 140, 200, 0};
-
-        Bitboard w = wp;
-        while (w) {
-            Square sq = firstSquare(w); w &= w - 1;
-            int f = fileOf(sq), r = rankOf(sq);
-            Bitboard adjFiles = fileBB(f);
-            if (f > 0) adjFiles |= fileBB(f - 1);
-            if (f < 7) adjFiles |= fileBB(f + 1);
-            if (!(bp & adjFiles & ranksAbove(r))) { mg += passedMG[r]; eg += passedEG[r]; }
-        }
-
-        Bitboard b = bp;
-        while (b) {
-            Square sq = firstSquare(b); b &= b - 1;
-            int f = fileOf(sq), r = rankOf(sq);
-            Bitboard adjFiles = fileBB(f);
-            if (f > 0) adjFiles |= fileBB(f - 1);
-            if (f < 7) adjFiles |= fileBB(f + 1);
-            if (!(wp & adjFiles & ranksBelow(r))) { mg -= passedMG[7 - r]; eg -= passedEG[7 - r]; }
-        }
-    }
-
-    // Every square attacked by a pawn of the given colour.
-    Bitboard pawnCover(const Board& board, Color c) {
-        Bitboard bb = board.getPieceBitboard(PieceType::PAWN, c), out = 0;
-        while (bb) {
-            Square s = firstSquare(bb); bb &= bb - 1;
-            out |= MoveGenerator::getPawnAttacks(s, c);
-        }
-        return out;
-    }
-
-    // Overall scale of the king-danger term, in percent.
-    constexpr int KING_DANGER_SCALE = 100;
-
-    // An unfinished king-safety rework, kept switched off but left in place
-    // because the measurements below are worth not repeating.
-    //   KS_NEW_TERMS - pawn attackers, pawn storm, defenders, open lines
-    //   KS_NEW_RAMP  - attacker count amplifies danger instead of discounting it
-    //
-    // Both on scored 26% over 63 games vs the build without them (~-180 Elo):
-    // the two multiply, so inflated units meet an amplified ramp and a single
-    // position can swing ~960cp, which is more than a queen. Each half alone
-    // came out level with the baseline over 60 games, so neither is bad by
-    // itself - the product is. The way forward is both on with
-    // KING_DANGER_SCALE somewhere near 25-35, not either half in isolation.
-    //
-    // Caveat on all of the above: 60-game matches at 60+0.6 only resolve
-    // effects around +/-100 Elo. A control that was eval-identical to the
-    // baseline and 11% faster measured -17 Elo over the same 60 games, so
-    // the two "level" readings mean "not a disaster", nothing finer.
-    constexpr bool KS_NEW_TERMS = false;
-    constexpr bool KS_NEW_RAMP  = false;
-
-    // Danger grows faster than the count of attackers: one piece pointed at
-    // the king is nothing, two is an annoyance, four with a line open is
-    // usually decisive. Percentages, so entries above 100 amplify.
-    constexpr int RAMP_NEW[8] = {0, 0, 100, 175, 250, 300, 340, 360};
-    // The original weighting, which can only ever discount the raw units.
-    constexpr int RAMP_OLD[8] = {0, 0,  50,  75,  88,  94,  97,  99};
-
-    // An enemy pawn near the king, by how many ranks away it still is. A
-    // storm both opens lines and gains tempo, so it is dangerous well before
-    // it makes contact.
-    constexpr int STORM_BY_RANK_DIST[8] = {0, 70, 45, 25, 12, 5, 0, 0};
-
-    struct KingZone {
-        Square   sq   = 64;
-        Bitboard zone = 0ULL;
-        int attackers = 0;   // distinct enemy pieces bearing on the zone
-        int units     = 0;   // weighted enemy pressure
-        int defenders = 0;   // weighted friendly cover of the same squares
-    };
-
-    // Enemy pawns marching at the king. The pawn shield only looks at our own
-    // pawns, so a storm that has not arrived yet is otherwise invisible - and
-    // by the time it arrives the lines are already open. Two files either
-    // side, because a king on c1 is very much a target for an a-file storm.
-    int pawnStorm(const Board& board, Color us, Square king, int& stormers) {
-        Bitboard pawns = board.getPieceBitboard(PieceType::PAWN, ~us);
-        int kf = fileOf(king), kr = rankOf(king), total = 0;
-        while (pawns) {
-            Square s = firstSquare(pawns); pawns &= pawns - 1;
-            if (std::abs(fileOf(s) - kf) > 2) continue;
-            int d = std::abs(rankOf(s) - kr);
-            total += STORM_BY_RANK_DIST[d];
-            if (d <= 3) stormers++;
-        }
-        return total;
-    }
-
-    // A heavy piece on a line into the king with none of our pawns left on
-    // it. This is what the storm is trying to create.
-    int openLinesToKing(const Board& board, Color us, Square king) {
-        Bitboard ourPawns = board.getPieceBitboard(PieceType::PAWN, us);
-        Bitboard heavy = board.getPieceBitboard(PieceType::ROOK,  ~us)
-                       | board.getPieceBitboard(PieceType::QUEEN, ~us);
-        int kf = fileOf(king), total = 0;
-        for (int f = std::max(0, kf - 2); f <= std::min(7, kf + 2); f++) {
-            Bitboard fb = fileBB(f);
-            if (ourPawns & fb) continue;              // still sheltered
-            if (heavy & fb) total += (f == kf) ? 50 : 35;
-        }
-        return total;
-    }
-
-    // Mobility and king safety in one pass, white-relative.
-    //
-    // Mobility counts squares a piece could actually move to, priced per
-    // piece type and game phase; squares covered by an enemy pawn are
-    // excluded, since a piece cannot usefully sit where a pawn just takes it.
-    //
-    // King safety needs exactly the same per-piece attack sets, and those
-    // sets are the most expensive thing in the whole evaluation, so the two
-    // terms share one loop: every attack bitboard is computed once and then
-    // asked three questions - where can this piece go, does it bear on the
-    // enemy king, does it cover our own.
-    void evaluateMobilityAndKingSafety(const Board& board, int& mg, int& eg) {
-        static const int mobMG[4] = {4, 5, 2, 1};   // knight, bishop, rook, queen
-        static const int mobEG[4] = {4, 5, 4, 2};
-        static const int atkWeight[4] = {30, 30, 60, 100};  // per attacked zone square
-        Bitboard occ = board.getAllPieces();
-
-        KingZone kz[2];
-        for (int i = 0; i < 2; i++) {
-            kz[i].sq = board.findKing(static_cast<Color>(i));
-            if (kz[i].sq < 64)
-                kz[i].zone = MoveGenerator::getKingAttacks(kz[i].sq) | (1ULL << kz[i].sq);
-        }
-
-        for (int i = 0; i < 2; i++) {
-            Color c = static_cast<Color>(i);
-            int sign = (c == Color::WHITE) ? 1 : -1;
-            Bitboard own = (c == Color::WHITE) ? board.getWhitePieces()
-                                               : board.getBlackPieces();
-            Bitboard bad = own | pawnCover(board, ~c);
-            KingZone& them = kz[1 - i];   // the king these pieces attack
-            KingZone& ours = kz[i];       // the king these pieces defend
-
-            auto tally = [&](PieceType t, int idx, auto attackFn) {
-                Bitboard bb = board.getPieceBitboard(t, c);
-                while (bb) {
-                    Square s = firstSquare(bb); bb &= bb - 1;
-                    Bitboard att = attackFn(s);   // the expensive part, done once
-                    int n = popCount(att & ~bad);
-                    mg += sign * n * mobMG[idx];
-                    eg += sign * n * mobEG[idx];
-                    int hits = popCount(att & them.zone);
-                    if (hits) { them.attackers++; them.units += atkWeight[idx] * hits; }
-                    if (KS_NEW_TERMS)
-                        ours.defenders += 15 * popCount(att & ours.zone);
-                }
-            };
-
-            tally(PieceType::KNIGHT, 0, [&](Square s){ return MoveGenerator::getKnightAttacks(s); });
-            tally(PieceType::BISHOP, 1, [&](Square s){ return MoveGenerator::getBishopAttacks(s, occ); });
-            tally(PieceType::ROOK,   2, [&](Square s){ return MoveGenerator::getRookAttacks(s, occ); });
-            tally(PieceType::QUEEN,  3, [&](Square s){ return MoveGenerator::getQueenAttacks(s, occ); });
-
-            // Pawns bear on the zone too - a pawn on a3 beside a king on b2
-            // is as dangerous as a piece - but they carry no mobility term.
-            // The whole pawn contribution counts as a single attacker.
-            if (KS_NEW_TERMS) {
-                Bitboard pawns = board.getPieceBitboard(PieceType::PAWN, c);
-                int pawnHits = 0;
-                while (pawns) {
-                    Square s = firstSquare(pawns); pawns &= pawns - 1;
-                    pawnHits += popCount(MoveGenerator::getPawnAttacks(s, c) & them.zone);
-                }
-                if (pawnHits) { them.attackers++; them.units += 20 * pawnHits; }
-            }
-        }
-
-        for (int i = 0; i < 2; i++) {
-            Color c = static_cast<Color>(i);
-            if (kz[i].sq >= 64) continue;
-            int stormers = 0, storm = 0, openLines = 0;
-            if (KS_NEW_TERMS) {
-                storm     = pawnStorm(board, c, kz[i].sq, stormers);
-                openLines = openLinesToKing(board, c, kz[i].sq);
-            }
-            // an attack is local superiority, so defenders come off the total
-            int danger = kz[i].units + storm + openLines - kz[i].defenders;
-            if (danger < 0) danger = 0;
-            int n = kz[i].attackers + (stormers ? 1 : 0);
-            danger = danger * (KS_NEW_RAMP ? RAMP_NEW : RAMP_OLD)[std::min(n, 7)] / 100;
-            danger = danger * KING_DANGER_SCALE / 100;
-            mg += (c == Color::WHITE) ? -danger : danger;
-        }
-    }
-
-    // Rooks on files with no friendly pawn in the way. A fully open file (no
-    // pawns of either colour) is worth more than a semi-open one, and both
-    // matter most while there is still a middlegame to invade.
-    void evaluateRookFiles(const Board& board, int& mg, int& eg) {
-        Bitboard wp = board.getPieceBitboard(PieceType::PAWN, Color::WHITE);
-        Bitboard bp = board.getPieceBitboard(PieceType::PAWN, Color::BLACK);
-
-        for (Color c : {Color::WHITE, Color::BLACK}) {
-            int sign = (c == Color::WHITE) ? 1 : -1;
-            Bitboard ownPawns   = (c == Color::WHITE) ? wp : bp;
-            Bitboard enemyPawns = (c == Color::WHITE) ? bp : wp;
-            Bitboard rooks = board.getPieceBitboard(PieceType::ROOK, c);
-            while (rooks) {
-                Square s = firstSquare(rooks); rooks &= rooks - 1;
-                Bitboard f = fileBB(fileOf(s));
-                if (ownPawns & f) continue;
-                if (enemyPawns & f) { mg += sign * 15; eg += sign *  8; }  // semi-open
-                else                { mg += sign * 30; eg += sign * 15; }  // open
-            }
-        }
-    }
-
-    // Game phase: 24 = all minor/major pieces on the board (middlegame),
-    // 0 = bare kings and pawns (pure endgame).
-    int gamePhase(const Board& board) {
-        int phase = 0;
-        for (Color c : {Color::WHITE, Color::BLACK}) {
-            phase += popCount(board.getPieceBitboard(PieceType::KNIGHT, c));
-            phase += popCount(board.getPieceBitboard(PieceType::BISHOP, c));
-            phase += popCount(board.getPieceBitboard(PieceType::ROOK,   c)) * 2;
-            phase += popCount(board.getPieceBitboard(PieceType::QUEEN,  c)) * 4;
-        }
-        return std::min(phase, 24);
-    }
-
-    // Endgame mop-up: when one side is a rook or more ahead and the defender
-    // has no pawns, reward driving the enemy king to the edge and bringing
-    // our king close so basic mates (KR-K, KQ-K) get converted.
-    int mopUpBonus(Square winnerKing, Square loserKing) {
-        int lf = fileOf(loserKing), lr = rankOf(loserKing);
-        int centerDist = std::max(3 - std::min(lf, 7 - lf), 0) +
-                         std::max(3 - std::min(lr, 7 - lr), 0);
-        int kingDist = std::abs(fileOf(winnerKing) - lf) +
-                       std::abs(rankOf(winnerKing) - lr);
-        return 10 * centerDist + 4 * (14 - kingDist);
-    }
-
-    // White-relative pawn shelter score. The attack-based half of king safety
-    // lives in evaluateMobilityAndKingSafety, which shares its attack sets
-    // with mobility.
-    int evaluateKingSafety(const Board& board) {
-        int score = 0;
-
-        auto pawnShield = [&](Color color) -> int {
-            Square king = board.findKing(color);
-            if (king >= 64) return 0;
-            int kf = fileOf(king), kr = rankOf(king);
-            // Only score when king is on the wing (castled position)
-            if (kf >= 2 && kf <= 5) return 0;
-
-            Bitboard pawns = board.getPieceBitboard(PieceType::PAWN, color);
-            int shield = 0;
-            int dir = (color == Color::WHITE) ? 1 : -1;
-            for (int f = std::max(0, kf - 1); f <= std::min(7, kf + 1); f++) {
-                bool found = false;
-                for (int d = 1; d <= 2 && !found; d++) {
-                    int r = kr + d * dir;
-                    if (r < 0 || r >= 8) break;
-                    if (getBit(pawns, makeSquare(f, r))) {
-                        shield += (d == 1) ? 15 : 8;
-                        found = true;
-                    }
-                }
-                if (!found) shield -= 10; // open file in front of king
-            }
-            return shield;
-        };
-
-        score += pawnShield(Color::WHITE);
-        score -= pawnShield(Color::BLACK);
-        return score;
+    // Tablebases only cover positions without castling rights and with at
+    // most as many pieces as the largest table found.
+    bool tablebaseCovers(const Board& board) {
+        int pieces = popCount(board.getAllPieces());
+        if (pieces > Tablebases::maxPieces()) return false;
+        return !board.canCastle(Color::WHITE, true) && !board.canCastle(Color::WHITE, false) &&
+               !board.canCastle(Color::BLACK, true) && !board.canCastle(Color::BLACK, false);
     }
 }
 
@@ -326,20 +23,30 @@ namespace {
 SearchEngine::SearchEngine()
     : timeLimit(5000), nodeLimit(0), nodesSearched(0),
       currentDepth(0), quietMode(false), useOpeningBook(false) {
-    tt.resize(TT_SIZE);
+    tt.resize(DEFAULT_TT_SIZE);
+    stack.resize(MAX_PLY);
     newGame();
 }
 
 void SearchEngine::newGame() {
     for (auto& e : tt) e = TTEntry();
-    for (int i = 0; i < MAX_PLY; i++)
-        for (int j = 0; j < MAX_KILLER_MOVES; j++)
-            killerMoves[i][j] = Move();
+    for (SearchFrame& frame : stack)
+        for (Move& killer : frame.killers) killer = Move();
     for (int i = 0; i < 64; i++)
         for (int j = 0; j < 64; j++)
             historyTable[i][j] = 0;
 }
 
+void SearchEngine::setHashSize(int megabytes) {
+    size_t bytes = static_cast<size_t>(std::max(megabytes, 1)) << 20;
+    size_t entries = 1;
+    while (entries * 2 * sizeof(TTEntry) <= bytes) entries *= 2;
+    // Built aside and swapped in, so a failed allocation keeps the old table
+    std::vector<TTEntry> table(entries);
+    tt.swap(table);
+    ttMask = entries - 1;
+}
+
 bool SearchEngine::isTimeUp() const {
     if (stopFlag && stopFlag->load(std::memory_order_relaxed)) return true;
     if (nodeLimit > 0 && nodesSearched >= nodeLimit) return true;
@@ -347,18 +54,31 @@ bool SearchEngine::isTimeUp() const {
     if (timeUpFlag) return true;
     // Only consult the clock every 1024 nodes; it is expensive per-node.
     if ((nodesSearched & 1023) != 0) return false;
+    if (clockStopped()) return false;
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::steady_clock::now() - searchStart).count();
     timeUpFlag = elapsed >= timeLimit;
     return timeUpFlag;
 }
 
+// The clock does not run while pondering. The first check after the flag
+// is cleared restarts it, so the budget counts from the ponderhit.
+bool SearchEngine::clockStopped() const {
+    if (!pondering) return false;
+    if (ponderFlag->load(std::memory_order_relaxed)) return true;
+    pondering   = false;
+    searchStart = std::chrono::steady_clock::now();
+    return false;
+}
+
 SearchResult SearchEngine::search(const Board& board, int depth) {
     SearchResult result;
     nodesSearched = 0;
+    tbHits        = 0;
     currentDepth  = 0;
     timeUpFlag    = false;
     searchStart   = std::chrono::steady_clock::now();
+    pondering     = ponderFlag && ponderFlag->load(std::memory_order_relaxed);
 
     std::vector<Move> moves = MoveGenerator::generateLegalMoves(board);
     if (moves.empty()) {
@@ -381,6 +101,29 @@ SearchResult SearchEngine::search(const Board& board, int depth) {
         }
     }
 
+    // Inside the tablebases, keep only the moves that preserve the best
+    // result. A win is played straight from the DTZ ranking - searching it
+    // would only spend clock on a position that is already decided.
+    if (tablebaseCovers(board)) {
+        Board probeBoard = board;
+        int outcome = 0;
+        if (Tablebases::rootProbe(probeBoard, moves, outcome)) {
+            tbHits++;
+            if (outcome > 0) {
+                result.bestMove = moves[0];
+                result.score    = TB_WIN_SCORE;
+                result.tbHits   = tbHits;
+                if (!quietMode) {
+                    OutputLine line;
+                    line << "info depth 1 score cp " << TB_WIN_SCORE << " nodes 0 tbhits "
+                         << tbHits << " pv " << moves[0];
+                    line.send();
+                }
+                return result;
+            }
+        }
+    }
+
     Move bestMove = moves[0];
     int bestScore = 0;
 
@@ -389,6 +132,12 @@ SearchResult SearchEngine::search(const Board& board, int depth) {
         return result;
     }
 
+    // The root list lives in frame 0 like every other ply's
+    SearchFrame& root = stack[0];
+    MoveList& rootMoves = root.moves;
+    rootMoves.clear();
+    for (const Move& m : moves) rootMoves.push_back(m);
+
     Board mutableBoard = board;
     int stableCount = 0;      // iterations in a row with the same best move
     bool scoreDropped = false;  // eval fell sharply on the last iteration
@@ -396,14 +145,14 @@ SearchResult SearchEngine::search(const Board& board, int depth) {
     for (int d = 1; d <= depth; d++) {
         currentDepth = d;
         // Previous iteration's best move is searched first. The root is ply 0.
-        orderMoves(mutableBoard, moves, bestMove, 0);
+        orderMoves(mutableBoard, root, bestMove, 0);
 
         // Aspiration window: search around the previous score first; on a
         // fail re-search that side with a full window.
         int alphaW = (d >= 3) ? std::max(bestScore - 35, -(MATE_SCORE + 1)) : -(MATE_SCORE + 1);
         int betaW  = (d >= 3) ? std::min(bestScore + 35,  (MATE_SCORE + 1)) :  (MATE_SCORE + 1);
 
-        Move iterBest = moves[0];
+        Move iterBest = rootMoves[0];
         int iterBestScore = std::numeric_limits<int>::min();
 
         while (true) {
@@ -411,8 +160,9 @@ SearchResult SearchEngine::search(const Board& board, int depth) {
             int alpha = alphaW;
             int beta  = betaW;
 
-            for (size_t i = 0; i < moves.size(); i++) {
-                mutableBoard.makeMove(moves[i]);
+            for (size_t i = 0; i < rootMoves.size(); i++) {
+                root.currentMove = rootMoves[i];
+                mutableBoard.makeMove(rootMoves[i]);
                 int score;
                 if (i == 0) {
                     score = -alphaBeta(mutableBoard, d - 1, -beta, -alpha, true, 1);
@@ -421,11 +171,11 @@ SearchResult SearchEngine::search(const Board& board, int depth) {
                     if (score > alpha && score < beta)
                         score = -alphaBeta(mutableBoard, d - 1, -beta, -alpha, true, 1);
                 }
-                mutableBoard.unmakeMove(moves[i]);
+                mutableBoard.unmakeMove(rootMoves[i]);
 
                 if (isTimeUp()) break;  // scores from an aborted search are garbage
 
-                if (score > iterBestScore) { iterBestScore = score; iterBest = moves[i]; }
+                if (score > iterBestScore) { iterBestScore = score; iterBest = rootMoves[i]; }
                 if (score > alpha) alpha = score;
             }
 
@@ -451,44 +201,43 @@ SearchResult SearchEngine::search(const Board& board, int depth) {
         }
         if (isTimeUp()) break;
 
-        if (!quietMode) {
-            // Principal variation: best root move, then follow TT best moves
-            std::string pv = moveToUci(bestMove);
-            Board pvBoard = board;
-            pvBoard.makeMove(bestMove);
-            for (int len = 1; len < d; len++) {
-                uint64_t h = pvBoard.getHash();
-                const TTEntry& e = tt[h & (TT_SIZE - 1)];
-                if (e.hash != h) break;
-                bool extended = false;
-                for (const Move& m : MoveGenerator::generateLegalMoves(pvBoard)) {
-                    if (m.from == e.bestMove.from && m.to == e.bestMove.to &&
-                        m.promotion == e.bestMove.promotion) {
-                        pv += " " + moveToUci(m);
-                        pvBoard.makeMove(m);
-                        extended = true;
-                        break;
-                    }
-                }
-                if (!extended) break;
-            }
+        if (infoCallback) {
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - searchStart).count();
+            infoCallback({d, bestScore, nodesSearched, static_cast<long long>(ms), bestMove});
+        }
 
+        if (!quietMode) {
             auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::steady_clock::now() - searchStart).count();
             long long nps = (ms > 0) ? nodesSearched * 1000LL / ms : 0;
 
-            std::cout << "info depth " << d;
+            OutputLine line;
+            line << "info depth " << d;
             if (bestScore > MATE_SCORE - 1000 || bestScore < -(MATE_SCORE - 1000)) {
                 // Mate scores encode ply distance from the root, so the
                 // distance falls straight out of the score.
                 int plies  = MATE_SCORE - std::abs(bestScore);
                 int mateIn = (plies + 1) / 2;
-                std::cout << " score mate " << (bestScore > 0 ? mateIn : -mateIn);
+                line << " score mate " << (bestScore > 0 ? mateIn : -mateIn);
             } else {
-                std::cout << " score cp " << bestScore;
+                line << " score cp " << bestScore;
+            }
+            line << " time " << static_cast<long long>(ms) << " nodes " << nodesSearched
+                 << " nps " << nps;
+            if (tbHits) line << " tbhits " << tbHits;
+
+            // Principal variation: best root move, then follow TT best moves
+            line << " pv " << bestMove;
+            Board pvBoard = board;
+            pvBoard.makeMove(bestMove);
+            for (int len = 1; len < d; len++) {
+                Move m = hashMove(pvBoard);
+                if (m.from == m.to) break;
+                line << ' ' << m;
+                pvBoard.makeMove(m);
             }
-            std::cout << " time " << ms << " nodes " << nodesSearched
-                      << " nps " << nps << " pv " << pv << std::endl;
+            line.send();
         }
 
         // Forced mate found: deeper search cannot improve it.
@@ -498,7 +247,7 @@ SearchResult SearchEngine::search(const Board& board, int depth) {
         // move has been stable for several iterations, and stretch the budget
         // when the score just dropped — that is when extra thought pays most.
         // The hard limit (isTimeUp) still aborts mid-iteration regardless.
-        if (timeLimit > 0) {
+        if (timeLimit > 0 && !clockStopped()) {
             auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::steady_clock::now() - searchStart).count();
             double budget = (softLimit > 0) ? softLimit : timeLimit * 0.5;
@@ -516,10 +265,36 @@ SearchResult SearchEngine::search(const Board& board, int depth) {
     result.score         = bestScore;
     result.depth         = currentDepth;
     result.nodesSearched = nodesSearched;
+    result.tbHits        = tbHits;
+
+    // The second PV move: what the GUI should ponder on
+    Board ponderBoard = board;
+    ponderBoard.makeMove(bestMove);
+    result.ponderMove = hashMove(ponderBoard);
 
     return result;
 }
 
+Move SearchEngine::hashMove(const Board& board) const {
+    uint64_t h = board.getHash();
+    const TTEntry& e = tt[h & ttMask];
+    if (e.hash != h) return Move();
+    MoveList moves;
+    MoveGenerator::generateLegalMoves(board, moves);
+    for (const Move& m : moves)
+        if (m.from == e.bestMove.from && m.to == e.bestMove.to &&
+            m.promotion == e.bestMove.promotion) return m;
+    return Move();
+}
+
+int SearchEngine::qsearch(const Board& board) {
+    nodesSearched = 0;
+    timeUpFlag    = false;
+    searchStart   = std::chrono::steady_clock::now();
+    Board mutableBoard = board;
+    return quiescence(mutableBoard, -(MATE_SCORE + 1), MATE_SCORE + 1, 0);
+}
+
 int SearchEngine::alphaBeta(Board& board, int depth, int alpha, int beta, bool nullMoveAllowed, int ply) {
     if (isTimeUp()) return 0;
     nodesSearched++;
@@ -543,7 +318,7 @@ int SearchEngine::alphaBeta(Board& board, int depth, int alpha, int beta, bool n
 
     // TT probe
     uint64_t hash  = board.getHash();
-    int      ttIdx = static_cast<int>(hash & (TT_SIZE - 1));
+    size_t   ttIdx = hash & ttMask;
     TTEntry& entry = tt[ttIdx];
     Move ttMove;
     bool hasTTMove = false;
@@ -558,6 +333,22 @@ int SearchEngine::alphaBeta(Board& board, int depth, int alpha, int beta, bool n
         }
     }
 
+    // Tablebase probe. Only right after a capture or pawn move: anywhere else
+    // in the same material the node was reached from a probed position, so
+    // the answer is already known higher up the tree.
+    if (board.getHalfMoveClock() == 0 && tablebaseCovers(board)) {
+        Tablebases::ProbeState state;
+        Tablebases::WDLScore wdl = Tablebases::probeWDL(board, &state);
+        if (state != Tablebases::FAIL) {
+            tbHits++;
+            // Cursed wins and blessed losses are fifty-move draws
+            int score = (wdl == Tablebases::WDL_WIN)  ?  TB_WIN_SCORE
+                      : (wdl == Tablebases::WDL_LOSS) ? -TB_WIN_SCORE : DRAW_SCORE;
+            entry = {hash, score, static_cast<int8_t>(std::min(depth + 6, 127)), 0, Move()};
+            return score;
+        }
+    }
+
     // Null move pruning
     if (nullMoveAllowed && !inCheck && depth >= 3) {
         Color stm = board.getSideToMove();
@@ -566,6 +357,7 @@ int SearchEngine::alphaBeta(Board& board, int depth, int alpha, int beta, bool n
         Bitboard king  = board.getPieceBitboard(PieceType::KING, stm);
         if (mine & ~pawns & ~king) {
             int R = (depth >= 6) ? 3 : 2;
+            stack[ply].currentMove = Move();
             board.makeNullMove();
             int nullScore = -alphaBeta(board, depth - R - 1, -beta, -beta + 1, false, ply + 1);
             board.unmakeNullMove();
@@ -573,18 +365,21 @@ int SearchEngine::alphaBeta(Board& board, int depth, int alpha, int beta, bool n
         }
     }
 
+    SearchFrame& frame = stack[ply];
+
     // Static eval for futility pruning (compute once, before move loop)
-    int staticEval = 0;
+    frame.staticEval = 0;
     bool doFutility = !inCheck && depth <= 2;
     if (doFutility) {
-        staticEval = evaluate(board);
-        if (board.getSideToMove() == Color::BLACK) staticEval = -staticEval;
+        frame.staticEval = evaluate(board);
+        if (board.getSideToMove() == Color::BLACK) frame.staticEval = -frame.staticEval;
     }
 
     // Pseudo-legal moves with lazy legality: each move is validated by making
     // it and testing for check, instead of filtering the whole list up front.
-    std::vector<Move> moves = MoveGenerator::generatePseudoLegalMoves(board);
-    orderMoves(board, moves, hasTTMove ? ttMove : Move(), ply);
+    MoveList& moves = frame.moves;
+    MoveGenerator::generatePseudoLegalMoves(board, moves);
+    orderMoves(board, frame, hasTTMove ? ttMove : Move(), ply);
 
     Color us           = board.getSideToMove();
     int  originalAlpha = alpha;
@@ -599,12 +394,13 @@ int SearchEngine::alphaBeta(Board& board, int depth, int alpha, int beta, bool n
         // Futility pruning: skip quiet moves when static eval + margin can't beat alpha
         if (doFutility && isQuiet && legalCount > 0) {
             int margin = (depth == 1) ? 100 : 300;
-            if (staticEval + margin <= alpha) continue;
+            if (frame.staticEval + margin <= alpha) continue;
         }
 
         board.makeMove(move);
         if (board.isInCheck(us)) { board.unmakeMove(move); continue; }
         legalCount++;
+        frame.currentMove = move;
         int score;
 
         if (legalCount == 1) {
@@ -715,14 +511,20 @@ int SearchEngine::quiescence(Board& board, int alpha, int beta, int ply) {
         if (standPat > alpha) alpha = standPat;
     }
 
-    std::vector<Move> allMoves = MoveGenerator::generatePseudoLegalMoves(board);
-    std::vector<Move> candidates;
-    candidates.reserve(allMoves.size());
-    for (const Move& m : allMoves)
-        if (inCheck || m.isCapture || m.promotion != PieceType::NONE)
-            candidates.push_back(m);   // in check: every evasion, not just captures
+    // Keep captures and promotions, compacted in place; in check, every
+    // evasion, not just captures
+    SearchFrame& frame = stack[ply];
+    MoveList& candidates = frame.moves;
+    MoveGenerator::generatePseudoLegalMoves(board, candidates);
+    if (!inCheck) {
+        size_t kept = 0;
+        for (size_t i = 0; i < candidates.size(); i++)
+            if (candidates[i].isCapture || candidates[i].promotion != PieceType::NONE)
+                candidates[kept++] = candidates[i];
+        candidates.resize(kept);
+    }
 
-    orderMoves(board, candidates, Move(), ply);
+    orderMoves(board, frame, Move(), ply);
 
     Color us = board.getSideToMove();
     int legalCount = 0;
@@ -741,6 +543,7 @@ int SearchEngine::quiescence(Board& board, int alpha, int beta, int ply) {
         board.makeMove(move);
         if (board.isInCheck(us)) { board.unmakeMove(move); continue; }
         legalCount++;
+        frame.currentMove = move;
         int score = -quiescence(board, -beta, -alpha, ply + 1);
         board.unmakeMove(move);
         if (score >= beta) return beta;
@@ -756,208 +559,22 @@ int SearchEngine::quiescence(Board& board, int alpha, int beta, int ply) {
 }
 
 int SearchEngine::evaluate(const Board& board) {
-    // Positions where no side can ever mate are dead draws
-    if (board.isInsufficientMaterial()) return 0;
-
-    // Tapered eval: score the position from a middlegame and an endgame
-    // perspective and blend by how much material is left, so e.g. the king
-    // hides behind pawns early but centralizes once the queens come off.
-    int mg = 0, eg = 0;
-    int materialW = 0, materialB = 0;
-
-    for (int c = 0; c < 2; c++) {
-        Color color = static_cast<Color>(c);
-        int sign = (color == Color::WHITE) ? 1 : -1;
-        for (int t = 0; t < 6; t++) {
-            PieceType type = static_cast<PieceType>(t);
-            Bitboard bb = board.getPieceBitboard(type, color);
-            while (bb) {
-                Square sq = firstSquare(bb);
-                bb &= bb - 1;
-                int value   = getPieceValue(type);
-                int valueEG = getPieceValueEG(type);
-                mg += sign * (value   + getPositionalValue(type, sq, color, false));
-                eg += sign * (valueEG + getPositionalValue(type, sq, color, true));
-                if (type != PieceType::KING)
-                    (color == Color::WHITE ? materialW : materialB) += value;
-            }
-        }
-    }
-
-    // Bishop pair
-    if (popCount(board.getPieceBitboard(PieceType::BISHOP, Color::WHITE)) >= 2) { mg += 30; eg += 30; }
-    if (popCount(board.getPieceBitboard(PieceType::BISHOP, Color::BLACK)) >= 2) { mg -= 30; eg -= 30; }
-
-    // Mobility and attack-based king danger, sharing one pass over the pieces
-    evaluateMobilityAndKingSafety(board, mg, eg);
-
-    // Rooks on open and semi-open files
-    evaluateRookFiles(board, mg, eg);
-
-    // Pawn structure
-    evaluatePawnStructure(board, mg, eg);
-
-    // King safety matters while there is attacking material; fade it out
-    mg += evaluateKingSafety(board);
-
-    // Mop-up knowledge for converting big material advantages without pawns
-    Square wk = board.findKing(Color::WHITE);
-    Square bk = board.findKing(Color::BLACK);
-    if (wk < 64 && bk < 64) {
-        if (materialW - materialB >= 400 && board.getPieceBitboard(PieceType::PAWN, Color::BLACK) == 0)
-            eg += mopUpBonus(wk, bk);
-        else if (materialB - materialW >= 400 && board.getPieceBitboard(PieceType::PAWN, Color::WHITE) == 0)
-            eg -= mopUpBonus(bk, wk);
-    }
-
-    int phase = gamePhase(board);
-    return (mg * phase + eg * (24 - phase)) / 24;
+    return Evaluation::evaluate(board);
 }
 
 int SearchEngine::getPieceValue(PieceType type) {
-    switch (type) {
-        case PieceType::PAWN:   return 100;
-        case PieceType::KNIGHT: return 320;
-        case PieceType::BISHOP: return 330;
-        case PieceType::ROOK:   return 500;
-        case PieceType::QUEEN:  return 1000;
-        case PieceType::KING:   return 20000;
-        default: return 0;
-    }
-}
-
-int SearchEngine::getPieceValueEG(PieceType type) {
-    switch (type) {
-        case PieceType::PAWN:   return 115;  // passed/promotion races matter more
-        case PieceType::KNIGHT: return 300;  // no outposts left to jump into
-        case PieceType::BISHOP: return 345;  // long diagonals open up
-        case PieceType::ROOK:   return 520;  // the dominant endgame piece
-        case PieceType::QUEEN:  return 1000;
-        case PieceType::KING:   return 20000;
-        default: return 0;
-    }
+    return Evaluation::pieceValue(type);
 }
 
-int SearchEngine::getPositionalValue(PieceType type, Square square, Color color, bool endgame) {
-    int file = fileOf(square);
-    int rank = rankOf(square);
-    int tableRank = (color == Color::BLACK) ? (7 - rank) : rank;
-    int idx = tableRank * 8 + file;
-
-    switch (type) {
-        case PieceType::PAWN: {
-            static const int pawnTable[64] = {
-                 0,  0,  0,  0,  0,  0,  0,  0,
-                 5, 10, 10,-20,-20, 10, 10,  5,
-                 5, -5,-10,  0,  0,-10, -5,  5,
-                 0,  0,  0, 20, 20,  0,  0,  0,
-                 5,  5, 10, 25, 25, 10,  5,  5,
-                10, 10, 20, 30, 30, 20, 10, 10,
-                50, 50, 50, 50, 50, 50, 50, 50,
-                 0,  0,  0,  0,  0,  0,  0,  0
-            };
-            // Endgame: only advancement matters, and it matters a lot
-            static const int pawnTableEG[64] = {
-                  0,   0,   0,   0,   0,   0,   0,   0,
-                 10,  10,  10,  10,  10,  10,  10,  10,
-                 10,  10,  10,  10,  10,  10,  10,  10,
-                 20,  20,  20,  20,  20,  20,  20,  20,
-                 35,  35,  35,  35,  35,  35,  35,  35,
-                 60,  60,  60,  60,  60,  60,  60,  60,
-                100, 100, 100, 100, 100, 100, 100, 100,
-                  0,   0,   0,   0,   0,   0,   0,   0
-            };
-            return endgame ? pawnTableEG[idx] : pawnTable[idx];
-        }
-        case PieceType::KNIGHT: {
-            static const int knightTable[64] = {
-                -50,-40,-30,-30,-30,-30,-40,-50,
-                -40,-20,  0,  5,  5,  0,-20,-40,
-                -30,  5, 10, 15, 15, 10,  5,-30,
-                -30,  0, 15, 20, 20, 15,  0,-30,
-                -30,  5, 15, 20, 20, 15,  5,-30,
-                -30,  0, 10, 15, 15, 10,  0,-30,
-                -40,-20,  0,  0,  0,  0,-20,-40,
-                -50,-40,-30,-30,-30,-30,-40,-50
-            };
-            return knightTable[idx];
-        }
-        case PieceType::BISHOP: {
-            static const int bishopTable[64] = {
-                -20,-10,-10,-10,-10,-10,-10,-20,
-                -10,  5,  0,  0,  0,  0,  5,-10,
-                -10, 10, 10, 10, 10, 10, 10,-10,
-                -10,  0, 10, 10, 10, 10,  0,-10,
-                -10,  5,  5, 10, 10,  5,  5,-10,
-                -10,  0,  5, 10, 10,  5,  0,-10,
-                -10,  0,  0,  0,  0,  0,  0,-10,
-                -20,-10,-10,-10,-10,-10,-10,-20
-            };
-            return bishopTable[idx];
-        }
-        case PieceType::ROOK: {
-            static const int rookTable[64] = {
-                 0,  0,  0,  5,  5,  0,  0,  0,
-                -5,  0,  0,  0,  0,  0,  0, -5,
-                -5,  0,  0,  0,  0,  0,  0, -5,
-                -5,  0,  0,  0,  0,  0,  0, -5,
-                -5,  0,  0,  0,  0,  0,  0, -5,
-                -5,  0,  0,  0,  0,  0,  0, -5,
-                 5, 10, 10, 10, 10, 10, 10,  5,
-                 0,  0,  0,  0,  0,  0,  0,  0
-            };
-            return rookTable[idx];
-        }
-        case PieceType::QUEEN: {
-            static const int queenTable[64] = {
-                -20,-10,-10, -5, -5,-10,-10,-20,
-                -10,  0,  5,  0,  0,  0,  0,-10,
-                -10,  5,  5,  5,  5,  5,  0,-10,
-                  0,  0,  5,  5,  5,  5,  0, -5,
-                 -5,  0,  5,  5,  5,  5,  0, -5,
-                -10,  0,  5,  5,  5,  5,  0,-10,
-                -10,  0,  0,  0,  0,  0,  0,-10,
-                -20,-10,-10, -5, -5,-10,-10,-20
-            };
-            return queenTable[idx];
-        }
-        case PieceType::KING: {
-            // Middlegame: stay castled behind the pawns
-            static const int kingTable[64] = {
-                 20, 30, 10,  0,  0, 10, 30, 20,
-                 20, 20,  0,  0,  0,  0, 20, 20,
-                -10,-20,-20,-20,-20,-20,-20,-10,
-                -20,-30,-30,-40,-40,-30,-30,-20,
-                -30,-40,-40,-50,-50,-40,-40,-30,
-                -30,-40,-40,-50,-50,-40,-40,-30,
-                -30,-40,-40,-50,-50,-40,-40,-30,
-                -30,-40,-40,-50,-50,-40,-40,-30
-            };
-            // Endgame: the king is a fighting piece — centralize it
-            static const int kingTableEG[64] = {
-                -50,-40,-30,-20,-20,-30,-40,-50,
-                -30,-20,-10,  0,  0,-10,-20,-30,
-                -30,-10, 20, 30, 30, 20,-10,-30,
-                -30,-10, 30, 40, 40, 30,-10,-30,
-                -30,-10, 30, 40, 40, 30,-10,-30,
-                -30,-10, 20, 30, 30, 20,-10,-30,
-                -30,-30,  0,  0,  0,  0,-30,-30,
-                -50,-30,-30,-30,-30,-30,-30,-50
-            };
-            return endgame ? kingTableEG[idx] : kingTable[idx];
-        }
-        default: return 0;
-    }
-}
-
-void SearchEngine::orderMoves(const Board& board, std::vector<Move>& moves,
+void SearchEngine::orderMoves(const Board& board, SearchFrame& frame,
                               const Move& ttMove, int ply) {
     bool hasTTMove = ttMove.from != ttMove.to;
+    MoveList& moves = frame.moves;
+    int* scores = frame.scores;
 
     // Score each move once, then sort by score.
-    std::vector<std::pair<int, Move>> scored;
-    scored.reserve(moves.size());
-    for (const Move& m : moves) {
+    for (size_t i = 0; i < moves.size(); i++) {
+        const Move& m = moves[i];
         int s;
         if (hasTTMove && m.from == ttMove.from && m.to == ttMove.to &&
             m.promotion == ttMove.promotion) {
@@ -984,20 +601,31 @@ void SearchEngine::orderMoves(const Board& board, std::vector<Move>& moves,
             // under the killers while preserving the relative order.
             s = getHistoryScore(m) / 16;
         }
-        scored.emplace_back(s, m);
+        scores[i] = s;
     }
 
-    std::stable_sort(scored.begin(), scored.end(),
-                     [](const auto& a, const auto& b) { return a.first > b.first; });
-    for (size_t i = 0; i < moves.size(); i++) moves[i] = scored[i].second;
+    // Stable insertion sort: lists are short, and std::stable_sort would
+    // want a temporary buffer from the heap.
+    for (size_t i = 1; i < moves.size(); i++) {
+        Move m = moves[i];
+        int  s = scores[i];
+        size_t j = i;
+        for (; j > 0 && scores[j - 1] < s; j--) {
+            moves[j]  = moves[j - 1];
+            scores[j] = scores[j - 1];
+        }
+        moves[j]  = m;
+        scores[j] = s;
+    }
 }
 
 bool SearchEngine::isKillerMove(const Move& move, int ply) {
     if (ply < 0 || ply >= MAX_PLY) return false;
+    const Move* killers = stack[ply].killers;
     for (int i = 0; i < MAX_KILLER_MOVES; i++)
-        if (killerMoves[ply][i].from == move.from &&
-            killerMoves[ply][i].to   == move.to   &&
-            killerMoves[ply][i].promotion == move.promotion) return true;
+        if (killers[i].from == move.from &&
+            killers[i].to   == move.to   &&
+            killers[i].promotion == move.promotion) return true;
     return false;
 }
 
@@ -1008,13 +636,14 @@ int SearchEngine::getHistoryScore(const Move& move) {
 
 void SearchEngine::recordKillerMove(const Move& move, int ply) {
     if (ply < 0 || ply >= MAX_PLY || move.isCapture) return;
+    Move* killers = stack[ply].killers;
     // Don't let the same move occupy both slots.
-    if (killerMoves[ply][0].from == move.from &&
-        killerMoves[ply][0].to   == move.to   &&
-        killerMoves[ply][0].promotion == move.promotion) return;
+    if (killers[0].from == move.from &&
+        killers[0].to   == move.to   &&
+        killers[0].promotion == move.promotion) return;
     for (int i = MAX_KILLER_MOVES - 1; i > 0; i--)
-        killerMoves[ply][i] = killerMoves[ply][i - 1];
-    killerMoves[ply][0] = move;
+        killers[i] = killers[i - 1];
+    killers[0] = move;
 }
 
 void SearchEngine::recordHistoryMove(const Move& move, int depth) {
@@ -1035,3 +664,9 @@ bool SearchEngine::loadEmbeddedOpeningBook() {
     useOpeningBook = openingBook.loadEmbedded();
     return useOpeningBook;
 }
+
+bool SearchEngine::loadPolyglotBook(const std::string& filename) {
+    if (!openingBook.loadPolyglot(filename)) return false;
+    if (!filename.empty()) useOpeningBook = true;
+    return true;
+}
@@ -3,10 +3,13 @@
 
 #include "types.h"
 #include "board.h"
+#include "movegen.h"
 #include "opening_book.h"
 #include <atomic>
 #include <chrono>
+#include <functional>
 #include <limits>
+#include <utility>
 #include <vector>
 
 struct TTEntry {
@@ -17,13 +20,34 @@ struct TTEntry {
     Move     bestMove;
 };
 
+// Per-ply search state. The engine allocates one array of these up front
+// and every search reuses it, so nodes in the tree do no heap allocation.
+struct SearchFrame {
+    MoveList moves;
+    int      scores[MoveList::MAX_MOVES];  // ordering scores, parallel to moves
+    int      staticEval = 0;
+    Move     currentMove;                  // move being searched at this ply
+    Move     killers[2];
+};
+
 struct SearchResult {
     Move bestMove;
     int score;
     int depth;
     int nodesSearched;
+    int tbHits;
+    Move ponderMove;  // expected reply to bestMove; from == to if unknown
+
+    SearchResult() : bestMove(), score(0), depth(0), nodesSearched(0), tbHits(0), ponderMove() {}
+};
 
-    SearchResult() : bestMove(), score(0), depth(0), nodesSearched(0) {}
+// Progress after a completed iteration of iterative deepening
+struct SearchInfo {
+    int depth;
+    int score;          // side to move's view
+    int nodes;
+    long long timeMs;   // since the search started
+    Move bestMove;
 };
 
 class SearchEngine {
@@ -31,9 +55,16 @@ public:
     SearchEngine();
 
     SearchResult search(const Board& board, int depth);
+    // Quiescence score (static eval resolved by captures), side to move's
+    // view, under the same time and node limits as search()
+    int qsearch(const Board& board);
 
     // Reset transposition table and move-ordering heuristics (ucinewgame)
     void newGame();
+    // Resize the transposition table to the largest power-of-two entry
+    // count that fits in the given megabytes; clears it. Throws
+    // std::bad_alloc if the memory is not there, leaving the old table.
+    void setHashSize(int megabytes);
 
     // Hard limit: the search aborts mid-iteration when it is reached.
     void setTimeLimit(int milliseconds) { timeLimit = milliseconds; }
@@ -45,13 +76,26 @@ public:
     // Disable the book for a search (e.g. "go infinite" = analysis mode)
     void setBookEnabled(bool enabled) { bookEnabled = enabled; }
     void setStopFlag(std::atomic<bool>* flag) { stopFlag = flag; }
+    // While *flag is set (go ponder) the time limits do not run; they start
+    // counting when it is cleared (ponderhit). Stop and node limits still apply.
+    void setPonderFlag(std::atomic<bool>* flag) { ponderFlag = flag; }
+    // Called after every completed iteration, in quiet mode too
+    void setInfoCallback(std::function<void(const SearchInfo&)> callback) { infoCallback = std::move(callback); }
 
     bool loadOpeningBook(const std::string& filename);
     bool loadEmbeddedOpeningBook();
+    // Polyglot .bin book probed ahead of the PGN/embedded one; "" closes it
+    bool loadPolyglotBook(const std::string& filename);
+    size_t polyglotBookEntries() const { return openingBook.polyglotEntries(); }
 
     int getPieceValue(PieceType type);
 
+    // Static exchange evaluation: expected material outcome of a capture
+    // after all profitable recaptures on the target square
+    int see(const Board& board, const Move& move);
+
 protected:
+    // Evaluation::evaluate unless overridden
     virtual int evaluate(const Board& board);
 
 private:
@@ -59,16 +103,26 @@ private:
     int softLimit{0};   // ms; 0 = derive from timeLimit
     int nodeLimit;  // node count; 0 = unlimited
     int nodesSearched;
+    int tbHits{0};      // successful tablebase probes this search
     int currentDepth;
     bool quietMode;
-    std::chrono::steady_clock::time_point searchStart;
+    mutable std::chrono::steady_clock::time_point searchStart;  // reset on ponderhit
     std::atomic<bool>* stopFlag{nullptr};
+    std::atomic<bool>* ponderFlag{nullptr};
+    mutable bool pondering{false};  // ponderFlag was set and not yet seen cleared
+    std::function<void(const SearchInfo&)> infoCallback;
     mutable bool timeUpFlag{false};  // latched result of the periodic clock check
 
-    static constexpr int TT_SIZE = 1 << 20;  // ~1M entries
+    static constexpr size_t DEFAULT_TT_SIZE = 1 << 20;  // ~1M entries
     std::vector<TTEntry> tt;
+    size_t ttMask = DEFAULT_TT_SIZE - 1;  // table size is a power of two
 
     bool isTimeUp() const;
+    bool clockStopped() const;
+
+    // The TT's best move for this position if it is legal there, else a
+    // null move (from == to). Follows the principal variation.
+    Move hashMove(const Board& board) const;
 
     OpeningBook openingBook;
     bool useOpeningBook;
@@ -80,27 +134,15 @@ private:
     // tree, so sharing a slot between them mostly just evicts useful moves.
     // Sized past the deepest search (64) with headroom for check extensions.
     static constexpr int MAX_PLY = 128;
-    Move killerMoves[MAX_PLY][MAX_KILLER_MOVES];
+    std::vector<SearchFrame> stack;  // MAX_PLY frames, indexed by ply
     int historyTable[64][64];
 
     int alphaBeta(Board& board, int depth, int alpha, int beta, bool nullMoveAllowed, int ply);
     int quiescence(Board& board, int alpha, int beta, int ply);
 
-    // Static exchange evaluation: expected material outcome of a capture
-    // after all profitable recaptures on the target square
-    int see(const Board& board, const Move& move);
-
-    int getPositionalValue(PieceType type, Square square, Color color, bool endgame);
-    // Endgame-specific material values: knights lose value as the board
-    // empties (fewer outposts/pawns to leap around), while bishops, rooks,
-    // and pawns gain value on a more open board or in a promotion race
-    // (classical piece-value tapering, e.g. Kaufman 1999). Used only for the
-    // eg half of the material sum in evaluate(); SEE, MVV-LVA ordering, and
-    // the mop-up material-diff threshold keep using the flat getPieceValue.
-    int getPieceValueEG(PieceType type);
-    // ttMove (if valid, i.e. from != to) is ordered first; ply selects the
-    // killer-move slot.
-    void orderMoves(const Board& board, std::vector<Move>& moves,
+    // Sorts frame.moves best first. ttMove (if valid, i.e. from != to) is
+    // ordered first; ply selects the killer-move slot.
+    void orderMoves(const Board& board, SearchFrame& frame,
                     const Move& ttMove, int ply);
 
     bool isKillerMove(const Move& move, int ply);
@@ -111,5 +153,8 @@ private:
 
 constexpr int MATE_SCORE = 10000;
 constexpr int DRAW_SCORE = 0;
+// A tablebase win: beyond any evaluation, below every mate score. Not
+// adjusted by ply, so it is safe to store in the transposition table.
+constexpr int TB_WIN_SCORE = MATE_SCORE - 2000;
 
 #endif // SEARCH_H
@@ -0,0 +1,842 @@
+#include "tbprobe.h"
+#include "mapped_file.h"
+#include "movegen.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+// The file format and the index encoding follow the reference probing code
+// by Ronald de Man (as used by Stockfish and Fathom). Comments below only
+// describe what is specific to this engine or easy to get wrong.
+
+namespace {
+    constexpr int TB_PIECES = 7;
+    constexpr int MAX_DTZ   = 1 << 18;  // rank given to wins inside the 50-move rule
+
+    enum TBFlag { STM = 1, MAPPED = 2, WIN_PLIES = 4, LOSS_PLIES = 8, WIDE = 16, SINGLE_VALUE = 128 };
+
+    const uint8_t WDL_MAGIC[4] = {0x71, 0xE8, 0x23, 0x5D};
+    const uint8_t DTZ_MAGIC[4] = {0xD7, 0x66, 0x0C, 0xA5};
+
+    const char PIECE_CHARS[] = "PNBRQK";  // indexed by PieceType
+
+    // Encoding tables, filled once by initEncoding()
+    int MapPawns[64];
+    int MapB1H1H7[64];
+    int MapA1D1D4[64];
+    int MapKK[10][64];
+    int Binomial[6][64];
+    int LeadPawnIdx[6][64];
+    int LeadPawnsSize[6][4];
+
+    int offA1H8(int sq) { return rankOf(sq) - fileOf(sq); }
+
+    template<typename T>
+    T readLE(const uint8_t* p) {
+        T v = 0;
+        for (size_t i = 0; i < sizeof(T); i++) v |= T(p[i]) << (8 * i);
+        return v;
+    }
+
+    template<typename T>
+    T readBE(const uint8_t* p) {
+        T v = 0;
+        for (size_t i = 0; i < sizeof(T); i++) v = (v << 8) | p[i];
+        return v;
+    }
+
+    // Tables are identified by their material: four bits per piece count,
+    // kings left out. Exact, so no hashing or collision handling is needed.
+    uint64_t packMaterial(const int counts[2][6]) {
+        uint64_t key = 0;
+        for (int c = 0; c < 2; c++)
+            for (int t = 0; t < 5; t++)
+                key |= uint64_t(counts[c][t]) << ((c * 5 + t) * 4);
+        return key;
+    }
+
+    uint64_t materialKey(const Board& board) {
+        int counts[2][6] = {};
+        for (int c = 0; c < 2; c++)
+            for (int t = 0; t < 5; t++)
+                counts[c][t] = popCount(board.getPieceBitboard(static_cast<PieceType>(t),
+                                                               static_cast<Color>(c)));
+        return packMaterial(counts);
+    }
+
+    // Piece codes as stored in the files: 1..6 white pawn..king, 9..14 black
+    uint8_t tbPieceCode(Piece p) {
+        return static_cast<uint8_t>(static_cast<int>(p.type) + 1 +
+                                    (p.color == Color::BLACK ? 8 : 0));
+    }
+
+    // Compression data for one sub-table (one side to move, one lead file)
+    struct PairsData {
+        uint8_t flags = 0;
+        size_t sizeofBlock = 0;
+        size_t span = 0;
+        int numBlocks = 0;
+        int maxSymLen = 0;
+        int minSymLen = 0;
+        const uint8_t* lowestSym   = nullptr;  // uint16 per symbol length
+        const uint8_t* btree       = nullptr;  // 3 bytes per symbol: left, right
+        const uint8_t* blockLength = nullptr;  // uint16 per block
+        int blockLengthSize = 0;
+        const uint8_t* sparseIndex = nullptr;  // 6 bytes per entry: block, offset
+        size_t sparseIndexSize = 0;
+        const uint8_t* data = nullptr;         // Huffman-coded blocks
+        std::vector<uint64_t> base64;
+        std::vector<uint8_t> symlen;
+        uint8_t  pieces[TB_PIECES] = {};
+        uint64_t groupIdx[TB_PIECES + 1] = {};
+        int      groupLen[TB_PIECES + 1] = {};
+        uint16_t mapIdx[4] = {};               // DTZ only
+
+        int left(int sym) const {
+            const uint8_t* e = btree + 3 * sym;
+            return ((e[1] & 0xF) << 8) | e[0];
+        }
+        int right(int sym) const {
+            const uint8_t* e = btree + 3 * sym;
+            return (e[2] << 4) | (e[1] >> 4);
+        }
+    };
+
+    struct TBTable {
+        bool isDTZ;
+        std::atomic<bool> ready{false};
+        MappedFile file;
+        const uint8_t* base = nullptr;  // first byte after the magic; null if unusable
+        const uint8_t* map  = nullptr;  // DTZ value map
+        uint64_t key  = 0;              // material with the stronger side white
+        uint64_t key2 = 0;              // ... and with it black
+        int  pieceCount = 0;
+        bool hasPawns = false;
+        bool hasUniquePieces = false;
+        uint8_t pawnCount[2] = {};      // [lead colour, other colour]
+        PairsData items[2][4];          // [side to move][lead pawn file a-d, or 0]
+
+        TBTable(const std::string& code, bool dtz) : isDTZ(dtz) {
+            // "KRPvKB": the left side is the stronger one, white in key
+            int counts[2][6] = {};
+            int side = 0;
+            for (char ch : code) {
+                if (ch == 'v') { side = 1; continue; }
+                int t = static_cast<int>(std::find(PIECE_CHARS, PIECE_CHARS + 6, ch) - PIECE_CHARS);
+                counts[side][t]++;
+                pieceCount++;
+            }
+            key = packMaterial(counts);
+            int swapped[2][6];
+            for (int t = 0; t < 6; t++) { swapped[0][t] = counts[1][t]; swapped[1][t] = counts[0][t]; }
+            key2 = packMaterial(swapped);
+
+            hasPawns = counts[0][0] + counts[1][0] > 0;
+            for (int c = 0; c < 2; c++)
+                for (int t = 0; t < 5; t++)
+                    if (counts[c][t] == 1) hasUniquePieces = true;
+
+            // The lead colour is the one with fewer pawns (but at least one),
+            // which compresses better.
+            bool whiteLeads = !counts[1][0] || (counts[0][0] && counts[1][0] >= counts[0][0]);
+            pawnCount[0] = static_cast<uint8_t>(counts[whiteLeads ? 0 : 1][0]);
+            pawnCount[1] = static_cast<uint8_t>(counts[whiteLeads ? 1 : 0][0]);
+        }
+
+        int sides() const { return (!isDTZ && key != key2) ? 2 : 1; }
+        PairsData* get(int stm, int file) {
+            return &items[isDTZ ? 0 : stm][hasPawns ? file : 0];
+        }
+    };
+
+    std::vector<std::string> tbPaths;
+    std::deque<TBTable> wdlTables, dtzTables;  // deque: entries never move
+    std::unordered_map<uint64_t, std::pair<TBTable*, TBTable*>> tableIndex;
+    int maxCardinality = 0;
+    std::mutex mapMutex;
+
+    void initEncoding() {
+        int code = 0;
+        for (int s = 0; s < 64; s++)
+            if (offA1H8(s) < 0) MapB1H1H7[s] = code++;
+
+        std::vector<int> diagonal;
+        code = 0;
+        for (int s = 0; s <= D4; s++) {
+            if (offA1H8(s) < 0 && fileOf(s) <= 3) MapA1D1D4[s] = code++;
+            else if (!offA1H8(s) && fileOf(s) <= 3) diagonal.push_back(s);
+        }
+        for (int s : diagonal) MapA1D1D4[s] = code++;
+
+        // The 462 legal placements of two kings with the first one in the
+        // a1-d1-d4 triangle; both kings on the diagonal are encoded last.
+        std::vector<std::pair<int, int>> bothOnDiagonal;
+        code = 0;
+        for (int idx = 0; idx < 10; idx++)
+            for (int s1 = 0; s1 <= D4; s1++)
+                if (MapA1D1D4[s1] == idx && (idx || s1 == B1)) {
+                    for (int s2 = 0; s2 < 64; s2++) {
+                        Bitboard near = MoveGenerator::getKingAttacks(static_cast<Square>(s1)) | (1ULL << s1);
+                        if (getBit(near, static_cast<Square>(s2))) continue;
+                        if (!offA1H8(s1) && offA1H8(s2) > 0) continue;
+                        if (!offA1H8(s1) && !offA1H8(s2)) bothOnDiagonal.emplace_back(idx, s2);
+                        else MapKK[idx][s2] = code++;
+                    }
+                }
+        for (auto& p : bothOnDiagonal) MapKK[p.first][p.second] = code++;
+
+        Binomial[0][0] = 1;
+        for (int n = 1; n < 64; n++)
+            for (int k = 0; k < 6 && k <= n; k++)
+                Binomial[k][n] = (k > 0 ? Binomial[k - 1][n - 1] : 0)
+                               + (k < n ? Binomial[k][n - 1] : 0);
+
+        // MapPawns orders a2-h7 so that the lead pawn (nearest the edge,
+        // lowest rank) has the highest value.
+        int available = 47;
+        for (int leadCount = 1; leadCount <= 5; leadCount++)
+            for (int f = 0; f < 4; f++) {
+                int idx = 0;
+                for (int r = 1; r <= 6; r++) {
+                    int sq = makeSquare(f, r);
+                    if (leadCount == 1) {
+                        MapPawns[sq] = available--;
+                        MapPawns[sq ^ 7] = available--;
+                    }
+                    LeadPawnIdx[leadCount][sq] = idx;
+                    idx += Binomial[leadCount - 1][MapPawns[sq]];
+                }
+                LeadPawnsSize[leadCount][f] = idx;
+            }
+    }
+
+    bool fileExists(const std::string& name) {
+        for (const std::string& dir : tbPaths)
+            if (std::ifstream(dir + "/" + name).good()) return true;
+        return false;
+    }
+
+    void addTable(const std::vector<int>& pieces) {
+        std::string code;
+        for (int t : pieces) code += PIECE_CHARS[t];
+        code.insert(code.find('K', 1), "v");
+        if (!fileExists(code + ".rtbw")) return;  // DTZ is optional, WDL is not
+
+        maxCardinality = std::max(static_cast<int>(pieces.size()), maxCardinality);
+        wdlTables.emplace_back(code, false);
+        dtzTables.emplace_back(code, true);
+        auto entry = std::make_pair(&wdlTables.back(), &dtzTables.back());
+        tableIndex[wdlTables.back().key]  = entry;
+        tableIndex[wdlTables.back().key2] = entry;
+    }
+
+    // ---- table layout ------------------------------------------------------
+
+    int setSymlen(PairsData* d, int s, std::vector<bool>& visited) {
+        visited[s] = true;  // the tree is acyclic
+        int sr = d->right(s);
+        if (sr == 0xFFF) return 0;
+        int sl = d->left(s);
+        if (!visited[sl]) d->symlen[sl] = static_cast<uint8_t>(setSymlen(d, sl, visited));
+        if (!visited[sr]) d->symlen[sr] = static_cast<uint8_t>(setSymlen(d, sr, visited));
+        return d->symlen[sl] + d->symlen[sr] + 1;
+    }
+
+    const uint8_t* setSizes(PairsData* d, const uint8_t* data) {
+        d->flags = *data++;
+        if (d->flags & SINGLE_VALUE) {
+            d->numBlocks = 0;
+            d->span = d->sparseIndexSize = 0;
+            d->minSymLen = *data++;  // the single stored value
+            return data;
+        }
+
+        // groupLen[] is zero-terminated; the matching groupIdx[] is the table size
+        uint64_t tbSize = d->groupIdx[std::find(d->groupLen, d->groupLen + TB_PIECES, 0) - d->groupLen];
+
+        d->sizeofBlock = size_t(1) << *data++;
+        d->span = size_t(1) << *data++;
+        d->sparseIndexSize = static_cast<size_t>((tbSize + d->span - 1) / d->span);
+        int padding = *data++;
+        d->numBlocks = static_cast<int>(readLE<uint32_t>(data)); data += 4;
+        d->blockLengthSize = d->numBlocks + padding;
+        d->maxSymLen = *data++;
+        d->minSymLen = *data++;
+        d->lowestSym = data;
+        d->base64.resize(d->maxSymLen - d->minSymLen + 1);
+
+        // Canonical Huffman: base64[l] is the lowest code of length
+        // minSymLen + l, left-aligned in 64 bits.
+        for (int i = static_cast<int>(d->base64.size()) - 2; i >= 0; i--)
+            d->base64[i] = (d->base64[i + 1] + readLE<uint16_t>(d->lowestSym + 2 * i)
+                                             - readLE<uint16_t>(d->lowestSym + 2 * (i + 1))) / 2;
+        for (size_t i = 0; i < d->base64.size(); i++)
+            d->base64[i] <<= 64 - i - d->minSymLen;
+
+        data += d->base64.size() * 2;
+        d->symlen.resize(readLE<uint16_t>(data)); data += 2;
+        d->btree = data;
+
+        std::vector<bool> visited(d->symlen.size());
+        for (size_t s = 0; s < d->symlen.size(); s++)
+            if (!visited[s]) d->symlen[s] = static_cast<uint8_t>(setSymlen(d, static_cast<int>(s), visited));
+
+        return data + d->symlen.size() * 3 + (d->symlen.size() & 1);
+    }
+
+    const uint8_t* setDtzMap(TBTable& e, const uint8_t* data, int maxFile) {
+        e.map = data;
+        for (int f = 0; f <= maxFile; f++) {
+            PairsData* d = e.get(0, f);
+            if (!(d->flags & MAPPED)) continue;
+            if (d->flags & WIDE) {
+                data += reinterpret_cast<uintptr_t>(data) & 1;  // word alignment
+                for (int i = 0; i < 4; i++) {
+                    d->mapIdx[i] = static_cast<uint16_t>((data - e.map) / 2 + 1);
+                    data += 2 * readLE<uint16_t>(data) + 2;
+                }
+            } else {
+                for (int i = 0; i < 4; i++) {
+                    d->mapIdx[i] = static_cast<uint16_t>(data - e.map + 1);
+                    data += *data + 1;
+                }
+            }
+        }
+        return data + (reinterpret_cast<uintptr_t>(data) & 1);
+    }
+
+    void setGroups(TBTable& e, PairsData* d, const int order[2], int f) {
+        int n = 0, firstLen = e.hasPawns ? 0 : e.hasUniquePieces ? 3 : 2;
+        d->groupLen[n] = 1;
+        for (int i = 1; i < e.pieceCount; i++) {
+            if (--firstLen > 0 || d->pieces[i] == d->pieces[i - 1]) d->groupLen[n]++;
+            else d->groupLen[++n] = 1;
+        }
+        d->groupLen[++n] = 0;
+
+        // Groups are stored in a per-table order: order[0] is the lead group,
+        // order[1] the remaining pawns when both sides have pawns.
+        bool pp = e.hasPawns && e.pawnCount[1];
+        int next = pp ? 2 : 1;
+        int freeSquares = 64 - d->groupLen[0] - (pp ? d->groupLen[1] : 0);
+        uint64_t idx = 1;
+
+        for (int k = 0; next < n || k == order[0] || k == order[1]; k++) {
+            if (k == order[0]) {
+                d->groupIdx[0] = idx;
+                idx *= e.hasPawns ? LeadPawnsSize[d->groupLen[0]][f]
+                     : e.hasUniquePieces ? 31332 : 462;
+            } else if (k == order[1]) {
+                d->groupIdx[1] = idx;
+                idx *= Binomial[d->groupLen[1]][48 - d->groupLen[0]];
+            } else {
+                d->groupIdx[next] = idx;
+                idx *= Binomial[d->groupLen[next]][freeSquares];
+                freeSquares -= d->groupLen[next++];
+            }
+        }
+        d->groupIdx[n] = idx;
+    }
+
+    void setup(TBTable& e, const uint8_t* data) {
+        data++;  // flags byte: split / has pawns, both implied by the material
+
+        const int sides = e.sides();
+        const int maxFile = e.hasPawns ? 3 : 0;
+        bool pp = e.hasPawns && e.pawnCount[1];
+
+        for (int f = 0; f <= maxFile; f++) {
+            for (int i = 0; i < sides; i++) *e.get(i, f) = PairsData();
+
+            int order[2][2] = {{*data & 0xF, pp ? *(data + 1) & 0xF : 0xF},
+                               {*data >> 4,  pp ? *(data + 1) >> 4  : 0xF}};
+            data += 1 + pp;
+
+            for (int k = 0; k < e.pieceCount; k++, data++)
+                for (int i = 0; i < sides; i++)
+                    e.get(i, f)->pieces[k] = static_cast<uint8_t>(i ? *data >> 4 : *data & 0xF);
+
+            for (int i = 0; i < sides; i++) setGroups(e, e.get(i, f), order[i], f);
+        }
+
+        data += reinterpret_cast<uintptr_t>(data) & 1;
+
+        for (int f = 0; f <= maxFile; f++)
+            for (int i = 0; i < sides; i++) data = setSizes(e.get(i, f), data);
+
+        if (e.isDTZ) data = setDtzMap(e, data, maxFile);
+
+        for (int f = 0; f <= maxFile; f++)
+            for (int i = 0; i < sides; i++) {
+                PairsData* d = e.get(i, f);
+                d->sparseIndex = data;
+                data += d->sparseIndexSize * 6;
+            }
+        for (int f = 0; f <= maxFile; f++)
+            for (int i = 0; i < sides; i++) {
+                PairsData* d = e.get(i, f);
+                d->blockLength = data;
+                data += d->blockLengthSize * 2;
+            }
+        for (int f = 0; f <= maxFile; f++)
+            for (int i = 0; i < sides; i++) {
+                PairsData* d = e.get(i, f);
+                data = reinterpret_cast<const uint8_t*>(
+                    (reinterpret_cast<uintptr_t>(data) + 0x3F) & ~uintptr_t(0x3F));
+                d->data = data;
+                data += static_cast<size_t>(d->numBlocks) * d->sizeofBlock;
+            }
+    }
+
+    // Maps the table's file on first use. Thread-safe; a missing or corrupt
+    // file is remembered as unusable.
+    bool mapped(TBTable& e, const Board& board) {
+        if (e.ready.load(std::memory_order_acquire)) return e.base != nullptr;
+        std::lock_guard<std::mutex> lock(mapMutex);
+        if (e.ready.load(std::memory_order_relaxed)) return e.base != nullptr;
+
+        std::string w, b;
+        for (int t = 5; t >= 0; t--) {
+            w += std::string(popCount(board.getPieceBitboard(static_cast<PieceType>(t), Color::WHITE)), PIECE_CHARS[t]);
+            b += std::string(popCount(board.getPieceBitboard(static_cast<PieceType>(t), Color::BLACK)), PIECE_CHARS[t]);
+        }
+        std::string name = (e.key == materialKey(board) ? w + 'v' + b : b + 'v' + w)
+                         + (e.isDTZ ? ".rtbz" : ".rtbw");
+
+        const uint8_t* magic = e.isDTZ ? DTZ_MAGIC : WDL_MAGIC;
+        for (const std::string& dir : tbPaths) {
+            if (!e.file.open(dir + "/" + name, MappedFile::Access::Random)) continue;
+            const uint8_t* data = e.file.data();
+            if (e.file.size() % 64 == 16 && std::equal(magic, magic + 4, data)) {
+                e.base = data + 4;
+                setup(e, e.base);
+                break;
+            }
+            e.file.close();  // wrong size or magic: not a Syzygy file
+        }
+        e.ready.store(true, std::memory_order_release);
+        return e.base != nullptr;
+    }
+
+    // ---- probing -------------------------------------------------------------
+
+    int decompressPairs(const PairsData* d, uint64_t idx) {
+        if (d->flags & SINGLE_VALUE) return d->minSymLen;
+
+        // The sparse index gives a block and offset near idx; walk from
+        // there to the block that actually holds idx.
+        uint32_t k = static_cast<uint32_t>(idx / d->span);
+        uint32_t block = readLE<uint32_t>(d->sparseIndex + 6 * k);
+        int offset     = readLE<uint16_t>(d->sparseIndex + 6 * k + 4);
+        int diff = static_cast<int>(idx % d->span) - static_cast<int>(d->span / 2);
+        offset += diff;
+
+        auto blockLen = [&](uint32_t b) { return static_cast<int>(readLE<uint16_t>(d->blockLength + 2 * b)); };
+        while (offset < 0) offset += blockLen(--block) + 1;
+        while (offset > blockLen(block)) offset -= blockLen(block++) + 1;
+
+        const uint8_t* ptr = d->data + static_cast<uint64_t>(block) * d->sizeofBlock;
+        uint64_t buf64 = readBE<uint64_t>(ptr); ptr += 8;
+        int buf64Size = 64;
+        int sym;
+
+        while (true) {
+            int len = 0;  // code length - minSymLen
+            while (buf64 < d->base64[len]) len++;
+            sym = static_cast<int>((buf64 - d->base64[len]) >> (64 - len - d->minSymLen));
+            sym += readLE<uint16_t>(d->lowestSym + 2 * len);
+            if (offset < d->symlen[sym] + 1) break;
+
+            offset -= d->symlen[sym] + 1;
+            len += d->minSymLen;
+            buf64 <<= len;
+            buf64Size -= len;
+            if (buf64Size <= 32) {
+                buf64Size += 32;
+                buf64 |= static_cast<uint64_t>(readBE<uint32_t>(ptr)) << (64 - buf64Size);
+                ptr += 4;
+            }
+        }
+
+        // Expand the pair-compressed symbol down to the single value at offset
+        while (d->symlen[sym]) {
+            int l = d->left(sym);
+            if (offset < d->symlen[l] + 1) sym = l;
+            else { offset -= d->symlen[l] + 1; sym = d->right(sym); }
+        }
+        return d->left(sym);
+    }
+
+    int mapScore(TBTable* e, int file, int value, Tablebases::WDLScore wdl) {
+        if (!e->isDTZ) return value - 2;
+
+        static const int WDL_MAP[] = {1, 3, 0, 2, 0};
+        const PairsData* d = e->get(0, file);
+        if (d->flags & MAPPED) {
+            int i = d->mapIdx[WDL_MAP[wdl + 2]] + value;
+            value = (d->flags & WIDE) ? readLE<uint16_t>(e->map + 2 * i) : e->map[i];
+        }
+        // Stored in moves or plies; always return plies
+        if ((wdl == Tablebases::WDL_WIN  && !(d->flags & WIN_PLIES)) ||
+            (wdl == Tablebases::WDL_LOSS && !(d->flags & LOSS_PLIES)) ||
+            wdl == Tablebases::WDL_CURSED_WIN || wdl == Tablebases::WDL_BLESSED_LOSS)
+            value *= 2;
+        return value + 1;
+    }
+
+    bool pawnsComp(int a, int b) { return MapPawns[a] < MapPawns[b]; }
+
+    int doProbeTable(const Board& board, TBTable* e, Tablebases::WDLScore wdl,
+                     Tablebases::ProbeState* result) {
+        int squares[TB_PIECES];
+        uint8_t pieces[TB_PIECES];
+        uint64_t idx;
+        int next = 0, size = 0, leadPawnsCnt = 0;
+        Bitboard b, leadPawns = 0;
+        int tbFile = 0;
+        int sideToMove = board.getSideToMove() == Color::WHITE ? 0 : 1;
+
+        // Tables are stored with the stronger side as white, and symmetric
+        // ones only for white to move: flip colours and squares otherwise.
+        bool symmetricBlackToMove = (e->key == e->key2 && sideToMove);
+        bool blackStronger = (materialKey(board) != e->key);
+        bool flip = symmetricBlackToMove || blackStronger;
+        int flipColor   = flip * 8;
+        int flipSquares = flip * 56;
+        int stm         = flip ^ sideToMove;
+
+        if (e->hasPawns) {
+            // The lead pawns' colour is the colour of the first stored piece
+            uint8_t pc = e->get(0, 0)->pieces[0] ^ flipColor;
+            Color leadColor = (pc & 8) ? Color::BLACK : Color::WHITE;
+            leadPawns = b = board.getPieceBitboard(PieceType::PAWN, leadColor);
+            do {
+                squares[size++] = firstSquare(b) ^ flipSquares;
+                b &= b - 1;
+            } while (b);
+            leadPawnsCnt = size;
+            std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCnt, pawnsComp));
+            tbFile = std::min(fileOf(squares[0]), 7 - fileOf(squares[0]));
+        }
+
+        // DTZ tables hold one side to move only
+        if (e->isDTZ) {
+            int flags = e->get(stm, tbFile)->flags;
+            if ((flags & STM) != stm && !(e->key == e->key2 && !e->hasPawns)) {
+                *result = Tablebases::CHANGE_STM;
+                return 0;
+            }
+        }
+
+        b = board.getAllPieces() ^ leadPawns;
+        do {
+            Square s = firstSquare(b); b &= b - 1;
+            squares[size] = s ^ flipSquares;
+            pieces[size++] = static_cast<uint8_t>(tbPieceCode(board.pieceAt(s)) ^ flipColor);
+        } while (b);
+
+        PairsData* d = e->get(stm, tbFile);
+
+        // Put the pieces in the order the table was encoded with
+        for (int i = leadPawnsCnt; i < size - 1; i++)
+            for (int j = i + 1; j < size; j++)
+                if (d->pieces[i] == pieces[j]) {
+                    std::swap(pieces[i], pieces[j]);
+                    std::swap(squares[i], squares[j]);
+                    break;
+                }
+
+        // Mirror so the lead piece is on files a-d
+        if (fileOf(squares[0]) > 3)
+            for (int i = 0; i < size; i++) squares[i] ^= 7;
+
+        if (e->hasPawns) {
+            idx = LeadPawnIdx[leadPawnsCnt][squares[0]];
+            std::stable_sort(squares + 1, squares + leadPawnsCnt, pawnsComp);
+            for (int i = 1; i < leadPawnsCnt; i++)
+                idx += Binomial[i][MapPawns[squares[i]]];
+        } else {
+            // Without pawns also mirror to ranks 1-4, then about the a1-h8
+            // diagonal so the first off-diagonal lead piece is below it
+            if (rankOf(squares[0]) > 3)
+                for (int i = 0; i < size; i++) squares[i] ^= 56;
+
+            for (int i = 0; i < d->groupLen[0]; i++) {
+                if (!offA1H8(squares[i])) continue;
+                if (offA1H8(squares[i]) > 0)
+                    for (int j = i; j < size; j++)
+                        squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+                break;
+            }
+
+            if (e->hasUniquePieces) {
+                int adjust1 = (squares[1] > squares[0]);
+                int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+                if (offA1H8(squares[0]))
+                    idx = (static_cast<uint64_t>(MapA1D1D4[squares[0]]) * 63
+                           + (squares[1] - adjust1)) * 62
+                          + squares[2] - adjust2;
+                else if (offA1H8(squares[1]))
+                    idx = (6 * 63 + rankOf(squares[0]) * 28
+                           + MapB1H1H7[squares[1]]) * 62
+                          + squares[2] - adjust2;
+                else if (offA1H8(squares[2]))
+                    idx = 6 * 63 * 62 + 4 * 28 * 62
+                          + rankOf(squares[0]) * 7 * 28
+                          + (rankOf(squares[1]) - adjust1) * 28
+                          + MapB1H1H7[squares[2]];
+                else
+                    idx = 6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28
+                          + rankOf(squares[0]) * 7 * 6
+                          + (rankOf(squares[1]) - adjust1) * 6
+                          + (rankOf(squares[2]) - adjust2);
+            } else {
+                idx = MapKK[MapA1D1D4[squares[0]]][squares[1]];
+            }
+        }
+
+        idx *= d->groupIdx[0];
+        int* groupSq = squares + d->groupLen[0];
+
+        // Remaining groups: each square is shifted down past the squares
+        // already taken by earlier groups
+        bool remainingPawns = e->hasPawns && e->pawnCount[1];
+        while (d->groupLen[++next]) {
+            std::stable_sort(groupSq, groupSq + d->groupLen[next]);
+            uint64_t n = 0;
+            for (int i = 0; i < d->groupLen[next]; i++) {
+                int adjust = static_cast<int>(std::count_if(squares, groupSq,
+                                  [&](int s) { return groupSq[i] > s; }));
+                n += Binomial[i + 1][groupSq[i] - adjust - 8 * remainingPawns];
+            }
+            remainingPawns = false;
+            idx += n * d->groupIdx[next];
+            groupSq += d->groupLen[next];
+        }
+
+        return mapScore(e, tbFile, decompressPairs(d, idx), wdl);
+    }
+
+    int probeTable(const Board& board, bool dtz, Tablebases::ProbeState* result,
+                   Tablebases::WDLScore wdl = Tablebases::WDL_DRAW) {
+        if (popCount(board.getAllPieces()) == 2) return Tablebases::WDL_DRAW;  // KvK
+
+        auto it = tableIndex.find(materialKey(board));
+        if (it == tableIndex.end()) { *result = Tablebases::FAIL; return 0; }
+        TBTable* e = dtz ? it->second.second : it->second.first;
+        if (!mapped(*e, board)) { *result = Tablebases::FAIL; return 0; }
+        return doProbeTable(board, e, wdl, result);
+    }
+
+    int dtzBeforeZeroing(Tablebases::WDLScore wdl) {
+        return wdl == Tablebases::WDL_WIN          ?  1  :
+               wdl == Tablebases::WDL_CURSED_WIN   ?  101 :
+               wdl == Tablebases::WDL_BLESSED_LOSS ? -101 :
+               wdl == Tablebases::WDL_LOSS         ? -1  : 0;
+    }
+
+    int signOf(int v) { return (v > 0) - (v < 0); }
+
+    bool isZeroing(const Board& board, const Move& m) {
+        return m.isCapture || board.pieceAt(m.from).type == PieceType::PAWN;
+    }
+
+    // The tables assume no en passant right and store a "don't care" value
+    // where the best move is a capture, so captures (and with checkZeroing,
+    // pawn moves) are searched explicitly before the table is consulted.
+    Tablebases::WDLScore searchWDL(Board& board, Tablebases::ProbeState* result, bool checkZeroing) {
+        using WDL = Tablebases::WDLScore;
+        WDL value, bestValue = Tablebases::WDL_LOSS;
+        MoveList moves;  // on the stack: this runs at search nodes
+        MoveGenerator::generateLegalMoves(board, moves);
+        size_t moveCount = 0;
+
+        for (const Move& m : moves) {
+            if (!m.isCapture && (!checkZeroing || board.pieceAt(m.from).type != PieceType::PAWN))
+                continue;
+            moveCount++;
+            board.makeMove(m);
+            value = static_cast<WDL>(-searchWDL(board, result, false));
+            board.unmakeMove(m);
+            if (*result == Tablebases::FAIL) return Tablebases::WDL_DRAW;
+            if (value > bestValue) {
+                bestValue = value;
+                if (value >= Tablebases::WDL_WIN) {
+                    *result = Tablebases::ZEROING_BEST_MOVE;
+                    return value;
+                }
+            }
+        }
+
+        // Every legal move already searched: the table value is not needed
+        // (and may be wrong, e.g. with an en passant right)
+        bool noMoreMoves = moveCount && moveCount == moves.size();
+        if (noMoreMoves) {
+            value = bestValue;
+        } else {
+            value = static_cast<WDL>(probeTable(board, false, result));
+            if (*result == Tablebases::FAIL) return Tablebases::WDL_DRAW;
+        }
+
+        if (bestValue >= value) {
+            *result = (bestValue > Tablebases::WDL_DRAW || noMoreMoves)
+                          ? Tablebases::ZEROING_BEST_MOVE : Tablebases::OK;
+            return bestValue;
+        }
+        *result = Tablebases::OK;
+        return value;
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+int Tablebases::init(const std::string& paths) {
+    static bool encodingReady = false;
+    if (!encodingReady) { initEncoding(); encodingReady = true; }
+
+    wdlTables.clear();
+    dtzTables.clear();
+    tableIndex.clear();
+    tbPaths.clear();
+    maxCardinality = 0;
+
+    if (paths.empty() || paths == "<empty>") return 0;
+
+#ifdef _WIN32
+    const char sep = ';';
+#else
+    const char sep = ':';
+#endif
+    size_t start = 0;
+    while (start <= paths.size()) {
+        size_t end = paths.find(sep, start);
+        if (end == std::string::npos) end = paths.size();
+        if (end > start) tbPaths.push_back(paths.substr(start, end - start));
+        start = end + 1;
+    }
+
+    // Every material split with up to 7 pieces, strongest side first
+    const int P = 0, K = 5;
+    for (int p1 = P; p1 < K; p1++) {
+        addTable({K, p1, K});
+        for (int p2 = P; p2 <= p1; p2++) {
+            addTable({K, p1, p2, K});
+            addTable({K, p1, K, p2});
+            for (int p3 = P; p3 < K; p3++)
+                addTable({K, p1, p2, K, p3});
+            for (int p3 = P; p3 <= p2; p3++) {
+                addTable({K, p1, p2, p3, K});
+                for (int p4 = P; p4 <= p3; p4++) {
+                    addTable({K, p1, p2, p3, p4, K});
+                    for (int p5 = P; p5 <= p4; p5++)
+                        addTable({K, p1, p2, p3, p4, p5, K});
+                    for (int p5 = P; p5 < K; p5++)
+                        addTable({K, p1, p2, p3, p4, K, p5});
+                }
+                for (int p4 = P; p4 < K; p4++) {
+                    addTable({K, p1, p2, p3, K, p4});
+                    for (int p5 = P; p5 <= p4; p5++)
+                        addTable({K, p1, p2, p3, K, p4, p5});
+                }
+            }
+            for (int p3 = P; p3 <= p1; p3++)
+                for (int p4 = P; p4 <= (p1 == p3 ? p2 : p3); p4++)
+                    addTable({K, p1, p2, K, p3, p4});
+        }
+    }
+    return static_cast<int>(wdlTables.size());
+}
+
+int Tablebases::maxPieces() {
+    return maxCardinality;
+}
+
+Tablebases::WDLScore Tablebases::probeWDL(Board& board, ProbeState* result) {
+    *result = OK;
+    return searchWDL(board, result, false);
+}
+
+int Tablebases::probeDTZ(Board& board, ProbeState* result) {
+    *result = OK;
+    WDLScore wdl = searchWDL(board, result, true);
+    if (*result == FAIL || wdl == WDL_DRAW) return 0;  // draws are not stored
+
+    // The best move zeroes the counter: the stored value is meaningless
+    if (*result == ZEROING_BEST_MOVE) return dtzBeforeZeroing(wdl);
+
+    int dtz = probeTable(board, true, result, wdl);
+    if (*result == FAIL) return 0;
+    if (*result != CHANGE_STM)
+        return (dtz + 100 * (wdl == WDL_BLESSED_LOSS || wdl == WDL_CURSED_WIN)) * signOf(wdl);
+
+    // The table holds the other side to move: one ply of search, keeping the
+    // move that reaches the result fastest.
+    int minDTZ = 0xFFFF;
+    for (const Move& m : MoveGenerator::generateLegalMoves(board)) {
+        bool zeroing = isZeroing(board, m);
+        board.makeMove(m);
+        dtz = zeroing ? -dtzBeforeZeroing(searchWDL(board, result, false))
+                      : -probeDTZ(board, result);
+        if (dtz == 1 && board.isInCheck(board.getSideToMove()) &&
+            MoveGenerator::generateLegalMoves(board).empty())
+            minDTZ = 1;  // mate
+        if (!zeroing) dtz += signOf(dtz);
+        if (dtz < minDTZ && signOf(dtz) == signOf(wdl)) minDTZ = dtz;
+        board.unmakeMove(m);
+        if (*result == FAIL) return 0;
+    }
+    return minDTZ == 0xFFFF ? -1 : minDTZ;  // no legal move: mated
+}
+
+bool Tablebases::rootProbe(Board& board, std::vector<Move>& moves, int& outcome) {
+    ProbeState result = OK;
+    int cnt50 = board.getHalfMoveClock();
+    std::vector<int> rank(moves.size()), dist(moves.size());
+
+    for (size_t i = 0; i < moves.size(); i++) {
+        board.makeMove(moves[i]);
+        int dtz;
+        if (board.getHalfMoveClock() == 0) {
+            dtz = dtzBeforeZeroing(static_cast<WDLScore>(-probeWDL(board, &result)));
+        } else if (board.isRepetition() || board.isDrawByFiftyMoves()) {
+            dtz = 0;
+        } else {
+            dtz = -probeDTZ(board, &result);
+            dtz = dtz > 0 ? dtz + 1 : dtz < 0 ? dtz - 1 : dtz;
+        }
+        if (dtz == 2 && board.isInCheck(board.getSideToMove()) &&
+            MoveGenerator::generateLegalMoves(board).empty())
+            dtz = 1;  // a mating move
+        board.unmakeMove(moves[i]);
+        if (result == FAIL) return false;
+
+        // Wins inside the fifty-move rule rank equally; beyond it they and
+        // losses are ranked by how close the fifty-move draw is.
+        rank[i] = dtz > 0 ? (dtz + cnt50 <= 99 ? MAX_DTZ : MAX_DTZ - (dtz + cnt50))
+                : dtz < 0 ? (-dtz * 2 + cnt50 < 100 ? -MAX_DTZ : -MAX_DTZ + (-dtz + cnt50))
+                : 0;
+        dist[i] = dtz;
+    }
+
+    int best = *std::max_element(rank.begin(), rank.end());
+    std::vector<size_t> keep;
+    for (size_t i = 0; i < moves.size(); i++)
+        if (rank[i] == best) keep.push_back(i);
+    // Fastest win first; when losing, the longest resistance (most
+    // negative dtz) first
+    std::stable_sort(keep.begin(), keep.end(),
+                     [&](size_t a, size_t b) { return dist[a] < dist[b]; });
+
+    std::vector<Move> filtered;
+    for (size_t i : keep) filtered.push_back(moves[i]);
+    moves.swap(filtered);
+
+    const int bound = MAX_DTZ - 100;
+    outcome = best >= bound ? 1 : best <= -bound ? -1 : 0;
+    return true;
+}
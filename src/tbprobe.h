@@ -0,0 +1,56 @@
+#ifndef TBPROBE_H
+#define TBPROBE_H
+
+#include "types.h"
+#include "board.h"
+#include <string>
+#include <vector>
+
+// Syzygy endgame tablebase probing (standard .rtbw / .rtbz files).
+//
+// WDL tables answer win/draw/loss for the side to move and are cheap enough
+// to consult inside the search; DTZ tables give the distance to the next
+// zeroing move (capture or pawn move) and are only probed at the root, where
+// they pick a move that makes progress against the fifty-move rule.
+// Files are memory mapped lazily, the first time a material combination is
+// probed, so a large tablebase set costs nothing until it is used.
+class Tablebases {
+public:
+    // Win/draw/loss from the side to move's point of view. Cursed wins and
+    // blessed losses are decided by the fifty-move rule (draws in practice).
+    enum WDLScore {
+        WDL_LOSS         = -2,
+        WDL_BLESSED_LOSS = -1,
+        WDL_DRAW         =  0,
+        WDL_CURSED_WIN   =  1,
+        WDL_WIN          =  2
+    };
+
+    enum ProbeState {
+        FAIL              =  0,  // no table, or a table could not be read
+        OK                =  1,
+        CHANGE_STM        = -1,  // DTZ table stores the other side to move
+        ZEROING_BEST_MOVE =  2   // the best move is a capture or pawn move
+    };
+
+    // Registers every table found in paths (directories separated by ':',
+    // or ';' on Windows) and returns how many were found. An empty string or
+    // "<empty>" disables probing.
+    static int init(const std::string& paths);
+
+    // Largest piece count (kings included) covered by the tables; 0 if none.
+    static int maxPieces();
+
+    // The board is modified during the probe but restored before returning.
+    // Positions with castling rights are not in the tables; callers check.
+    static WDLScore probeWDL(Board& board, ProbeState* result);
+    static int probeDTZ(Board& board, ProbeState* result);
+
+    // Ranks the root moves by DTZ and keeps only the best-ranked ones, the
+    // fastest conversion first. outcome is set to +1 (win), 0 (draw, cursed
+    // win or blessed loss) or -1 (loss). Returns false if any probe failed,
+    // leaving moves untouched.
+    static bool rootProbe(Board& board, std::vector<Move>& moves, int& outcome);
+};
+
+#endif // TBPROBE_H
@@ -1,10 +1,14 @@
 #include "uci.h"
 #include "movegen.h"
+#include "output.h"
+#include "perft.h"
+#include "tbprobe.h"
 #include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <cctype>
 #include <cstdlib>
+#include <new>
 
 UCIEngine::UCIEngine(const std::string& exePath) : isRunning(false) {
     board.setupStartingPosition();
@@ -14,6 +18,9 @@ UCIEngine::UCIEngine(const std::string& exePath) : isRunning(false) {
     // without rebuilding). GUIs launch the engine from arbitrary working
     // directories, so probe a few likely locations including next to the
     // binary. Otherwise fall back to the book embedded in the executable.
+    // Parsing a PGN takes a while, so it happens off the command loop:
+    // "uci" is answered at once, and "isready" (or anything that needs the
+    // search) waits for the book.
     std::vector<std::string> candidates = {"src/eco.pgn", "eco.pgn", "../src/eco.pgn"};
     size_t slash = exePath.find_last_of("/\\");  // handle Windows separators too
     if (slash != std::string::npos) {
@@ -21,26 +28,115 @@ UCIEngine::UCIEngine(const std::string& exePath) : isRunning(false) {
         candidates.push_back(exeDir + "/eco.pgn");
         candidates.push_back(exeDir + "/../src/eco.pgn");
     }
-    bool loaded = false;
-    for (const std::string& path : candidates)
-        if (search.loadOpeningBook(path)) { loaded = true; break; }
-    if (!loaded) search.loadEmbeddedOpeningBook();
+    bookThread = std::thread([this, candidates] {
+        bool loaded = false;
+        for (const std::string& path : candidates)
+            if (search.loadOpeningBook(path)) { loaded = true; break; }
+        if (!loaded) search.loadEmbeddedOpeningBook();
+    });
+
+    registerOptions();
+    search.setStopFlag(&stopRequested);
+    search.setPonderFlag(&pondering);
+    searchThread = std::thread(&UCIEngine::searchLoop, this);
 }
 
 UCIEngine::~UCIEngine() {
+    waitForBook();
+    stopSearch();
+    {
+        std::lock_guard<std::mutex> lock(searchMutex);
+        workerExit = true;
+    }
+    searchCv.notify_all();
+    searchThread.join();
+}
+
+void UCIEngine::searchLoop() {
+    std::unique_lock<std::mutex> lock(searchMutex);
+    for (;;) {
+        searchCv.wait(lock, [this] { return jobPending || workerExit; });
+        if (workerExit) return;
+        SearchJob current = job;
+        jobPending = false;
+        lock.unlock();
+
+        if (current.perft) {
+            runPerft(current.board, current.depth);
+            lock.lock();
+            searching = false;
+            searchCv.notify_all();
+            continue;
+        }
+
+        SearchResult result = search.search(current.board, current.depth);
+
+        // UCI: after go infinite or go ponder, bestmove must not be sent
+        // until "stop" (or "ponderhit"), even if the search ended early
+        lock.lock();
+        searchCv.wait(lock, [this] { return !holdBestMove || stopRequested.load(); });
+        sendBestMove(result.bestMove, result.ponderMove);
+        searching = false;
+        searchCv.notify_all();
+    }
+}
+
+void UCIEngine::waitForBook() {
+    if (bookThread.joinable()) bookThread.join();
+}
+
+void UCIEngine::stopSearch() {
+    std::unique_lock<std::mutex> lock(searchMutex);
     stopRequested = true;
-    if (searchThread.joinable()) searchThread.join();
+    searchCv.notify_all();
+    searchCv.wait(lock, [this] { return !searching; });
+}
+
+void UCIEngine::interruptSearch() {
+    std::lock_guard<std::mutex> lock(searchMutex);
+    stopRequested = true;
+    searchCv.notify_all();
+}
+
+void UCIEngine::inputLoop() {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::vector<std::string> tokens = split(line);
+        if (tokens.empty()) continue;
+        const std::string& cmd = tokens[0];
+        if (cmd == "stop" || cmd == "quit") interruptSearch();
+        else if (cmd == "ponderhit") handlePonderHit();
+        {
+            std::lock_guard<std::mutex> lock(inputMutex);
+            commands.push_back(line);
+        }
+        inputCv.notify_one();
+        if (cmd == "quit") break;
+    }
+    std::lock_guard<std::mutex> lock(inputMutex);
+    inputClosed = true;
+    inputCv.notify_one();
 }
 
 void UCIEngine::run() {
     isRunning = true;
-    std::string line;
-    
-    while (isRunning && std::getline(std::cin, line)) {
-        if (!line.empty()) {
-            handleCommand(line);
+    // Output goes through OutputLine, so there is no cout buffer for reads
+    // on the input thread to flush
+    std::cin.tie(nullptr);
+    inputThread = std::thread(&UCIEngine::inputLoop, this);
+
+    while (isRunning) {
+        std::string line;
+        {
+            std::unique_lock<std::mutex> lock(inputMutex);
+            inputCv.wait(lock, [this] { return !commands.empty() || inputClosed; });
+            if (commands.empty()) break;  // end of input
+            line = std::move(commands.front());
+            commands.pop_front();
         }
+        handleCommand(line);
     }
+    inputThread.join();
 }
 
 void UCIEngine::handleCommand(const std::string& command) {
@@ -60,8 +156,12 @@ void UCIEngine::handleCommand(const std::string& command) {
         handlePosition(tokens);
     } else if (cmd == "go") {
         handleGo(tokens);
+    } else if (cmd == "setoption") {
+        handleSetOption(tokens);
     } else if (cmd == "stop") {
         handleStop();
+    } else if (cmd == "ponderhit") {
+        handlePonderHit();
     } else if (cmd == "quit") {
         handleQuit();
     }
@@ -72,57 +172,149 @@ void UCIEngine::handleCommand(const std::string& command) {
 #endif
 
 void UCIEngine::handleUCI() {
-    std::cout << "id name ChessEngine " << GIT_SHA << std::endl;
-    std::cout << "id author Chess Engine Project" << std::endl;
-    std::cout << "uciok" << std::endl;
+    OutputLine line;
+    line << "id name ChessEngine " << GIT_SHA;
+    line.send();
+    line << "id author Chess Engine Project";
+    line.send();
+    for (const std::string& option : options.describe()) {
+        line << option;
+        line.send();
+    }
+    line << "uciok";
+    line.send();
 }
 
 void UCIEngine::handleIsReady() {
-    std::cout << "readyok" << std::endl;
+    waitForBook();
+    OutputLine line;
+    line << "readyok";
+    line.send();
 }
 
 void UCIEngine::handleNewGame() {
     // Make sure no search is reading the engine state while we reset it
-    stopRequested = true;
-    if (searchThread.joinable()) searchThread.join();
+    waitForBook();
+    stopSearch();
     board.setupStartingPosition();
+    positionStart.clear();
+    positionMoves.clear();
     search.newGame();
 }
 
+// setoption name <id> [value <x>]; both the id and the value may contain
+// spaces, and ids are matched case-insensitively as the protocol requires.
+void UCIEngine::handleSetOption(const std::vector<std::string>& tokens) {
+    std::string name, value;
+    std::string* target = nullptr;
+    for (size_t i = 1; i < tokens.size(); i++) {
+        if (tokens[i] == "name" && target != &value) { target = &name; continue; }
+        if (tokens[i] == "value" && target == &name) { target = &value; continue; }
+        if (!target) continue;
+        if (!target->empty()) *target += " ";
+        *target += tokens[i];
+    }
+
+    // Options change state the search reads, so never while it runs
+    waitForBook();
+    stopSearch();
+
+    std::string error;
+    if (!options.set(name, value, error)) {
+        OutputLine line;
+        line << "info string " << error;
+        line.send();
+    }
+}
+
+void UCIEngine::registerOptions() {
+    using Option = OptionRegistry::Option;
+    // The default matches the table the search starts with (1M entries)
+    options.addSpin("Hash", 24, 1, 65536, [this](const Option& o, std::string& error) {
+        try {
+            search.setHashSize(o.asInt());
+            return true;
+        } catch (const std::bad_alloc&) {
+            error = "cannot allocate " + o.value + " MB for Hash, keeping the previous table";
+            return false;
+        }
+    });
+    options.addButton("Clear Hash", [this](const Option&, std::string&) {
+        search.newGame();
+        return true;
+    });
+    // Only tells the GUI it may send go ponder; the engine always accepts it
+    options.addCheck("Ponder", false);
+    options.addCheck("OwnBook", true, [this](const Option& o, std::string&) {
+        ownBook = o.asBool();
+        return true;
+    });
+    options.addSpin("Move Overhead", 100, 0, 5000, [this](const Option& o, std::string&) {
+        moveOverhead = o.asInt();
+        return true;
+    });
+
+    options.addString("BookFile", "", [this](const Option& o, std::string& error) {
+        if (!search.loadPolyglotBook(o.value)) {
+            error = "cannot open Polyglot book " + o.value + ", keeping the previous book";
+            return false;
+        }
+        if (!o.value.empty()) {
+            OutputLine line;
+            line << "info string Polyglot book " << o.value << ": "
+                 << search.polyglotBookEntries() << " entries";
+            line.send();
+        }
+        return true;
+    });
+    options.addString("SyzygyPath", "", [](const Option& o, std::string&) {
+        int found = Tablebases::init(o.value);
+        OutputLine line;
+        line << "info string found " << found << " tablebases";
+        if (found) line << " (up to " << Tablebases::maxPieces() << " pieces)";
+        line.send();
+        return true;
+    });
+}
+
+// position startpos|fen <fen> [moves ...]. GUIs and lichess-bot resend the
+// whole game before every move; when the start matches the last command and
+// its moves are a prefix of the new list, only the new moves are applied.
 void UCIEngine::handlePosition(const std::vector<std::string>& tokens) {
     if (tokens.size() < 2) return;
-    
-    if (tokens[1] == "startpos") {
-        board.setupStartingPosition();
 
-        // Handle moves
-        for (size_t i = 2; i < tokens.size(); i++) {
-            if (tokens[i] == "moves") {
-                for (size_t j = i + 1; j < tokens.size(); j++) {
-                    if (!tryApplyMove(tokens[j])) break;
-                }
-                break;
-            }
-        }
+    std::string start;
+    size_t movesIndex = tokens.size();
+    if (tokens[1] == "startpos") {
+        start = "startpos";
+        if (tokens.size() > 2 && tokens[2] == "moves") movesIndex = 3;
     } else if (tokens[1] == "fen") {
-        // Handle FEN position
-        std::string fen;
-        size_t movesIndex = tokens.size();
-        
-        for (size_t i = 2; i < tokens.size() && tokens[i] != "moves"; i++) {
-            if (i > 2) fen += " ";
-            fen += tokens[i];
-            movesIndex = i + 1;
-        }
-        
-        board.fromFEN(fen);
-        
-        // Handle moves after FEN
-        if (movesIndex < tokens.size() && tokens[movesIndex] == "moves") {
-            for (size_t i = movesIndex + 1; i < tokens.size(); i++) {
-                if (!tryApplyMove(tokens[i])) break;
-            }
+        for (size_t i = 2; i < tokens.size(); i++) {
+            if (tokens[i] == "moves") { movesIndex = i + 1; break; }
+            if (i > 2) start += " ";
+            start += tokens[i];
         }
+    } else {
+        return;
+    }
+
+    size_t newMoves = movesIndex < tokens.size() ? tokens.size() - movesIndex : 0;
+    bool extends = !positionStart.empty() && start == positionStart &&
+                   positionMoves.size() <= newMoves &&
+                   std::equal(positionMoves.begin(), positionMoves.end(),
+                              tokens.begin() + movesIndex);
+    size_t applied = positionMoves.size();
+    if (!extends) {
+        if (start == "startpos") board.setupStartingPosition();
+        else board.fromFEN(start);
+        positionStart = start;
+        positionMoves.clear();
+        applied = 0;
+    }
+
+    for (size_t i = movesIndex + applied; i < tokens.size(); i++) {
+        if (!tryApplyMove(tokens[i])) break;
+        positionMoves.push_back(tokens[i]);
     }
 }
 
@@ -133,23 +325,51 @@ bool UCIEngine::tryApplyMove(const std::string& moveStr) {
     Move parsed = parseMove(moveStr);
     if (parsed.from == parsed.to) return false;
 
-    for (const Move& legal : MoveGenerator::generateLegalMoves(board)) {
+    MoveList legalMoves;
+    MoveGenerator::generateLegalMoves(board, legalMoves);
+    for (const Move& legal : legalMoves) {
         if (legal.from == parsed.from && legal.to == parsed.to &&
             legal.promotion == parsed.promotion) {
             board.makeMove(legal);
             return true;
         }
     }
-    std::cout << "info string ignoring illegal move " << moveStr << std::endl;
+    OutputLine line;
+    line << "info string ignoring illegal move " << moveStr;
+    line.send();
     return false;
 }
 
 void UCIEngine::handleGo(const std::vector<std::string>& tokens) {
+    waitForBook();
+    // go perft <depth>: leaf counts per root move, for move generation
+    // debugging. Runs on the search thread like a search, so "stop" and
+    // "quit" cut it short.
+    if (tokens.size() >= 3 && tokens[1] == "perft") {
+        stopSearch();
+        int depth = 0;
+        try { depth = std::stoi(tokens[2]); } catch (...) {}
+        {
+            std::lock_guard<std::mutex> lock(searchMutex);
+            job.board     = board;
+            job.depth     = depth;
+            job.perft     = true;
+            holdBestMove  = false;
+            pondering     = false;
+            stopRequested = false;
+            jobPending    = true;
+            searching     = true;
+        }
+        searchCv.notify_all();
+        return;
+    }
+
     int depth     = 0;
     int nodes     = 0;
     int movetime  = 0;
     int wtime = 0, btime = 0, winc = 0, binc = 0, movestogo = 0;
     bool infinite = false;
+    bool ponder   = false;
     constexpr int MAX_PRACTICAL_DEPTH = 12;
 
     for (size_t i = 1; i < tokens.size(); i++) {
@@ -167,6 +387,7 @@ void UCIEngine::handleGo(const std::vector<std::string>& tokens) {
         else if (tokens[i] == "binc")      binc      = intArg();
         else if (tokens[i] == "movestogo") movestogo = intArg();
         else if (tokens[i] == "infinite")  infinite  = true;
+        else if (tokens[i] == "ponder")    ponder    = true;
     }
 
     int timeLimitMs = 0;  // hard limit
@@ -185,7 +406,7 @@ void UCIEngine::handleGo(const std::vector<std::string>& tokens) {
         int mtg = (movestogo > 0) ? movestogo : 40;
         softMs      = std::max(myTime / mtg + myInc / 2, 10);
         timeLimitMs = std::max(std::min(myTime / 4, softMs * 5), softMs);
-        timeLimitMs = std::min(timeLimitMs, std::max(myTime - 100, 10));
+        timeLimitMs = std::min(timeLimitMs, std::max(myTime - moveOverhead, 10));
         softMs      = std::min(softMs, timeLimitMs);
     } else if (!infinite && depth == 0 && nodes == 0) {
         timeLimitMs = 5000;  // bare "go": think for 5 seconds instead of forever
@@ -193,48 +414,74 @@ void UCIEngine::handleGo(const std::vector<std::string>& tokens) {
     }
 
     // Stop any in-progress search before starting a new one
-    stopRequested = true;
-    if (searchThread.joinable()) searchThread.join();
-    stopRequested = false;
+    stopSearch();
 
     search.setTimeLimit(timeLimitMs);
     search.setSoftTimeLimit(softMs);
     search.setNodeLimit(nodes);
-    search.setStopFlag(&stopRequested);
     // The book answers instantly without producing any evaluation, so use it
     // only in real timed games (clocks present). Analysis requests -
     // infinite, fixed depth/nodes/movetime - always search.
-    search.setBookEnabled(wtime > 0 || btime > 0);
-
-    if (depth > MAX_PRACTICAL_DEPTH && timeLimitMs == 0 && nodes == 0 && !infinite) {
-        std::cout << "info string requested depth " << depth
-                  << " capped to " << MAX_PRACTICAL_DEPTH
-                  << " (no time/nodes limit set)" << std::endl;
+    search.setBookEnabled(ownBook && (wtime > 0 || btime > 0));
+
+    if (depth > MAX_PRACTICAL_DEPTH && timeLimitMs == 0 && nodes == 0 && !infinite && !ponder) {
+        OutputLine line;
+        line << "info string requested depth " << depth
+             << " capped to " << MAX_PRACTICAL_DEPTH
+             << " (no time/nodes limit set)";
+        line.send();
         depth = MAX_PRACTICAL_DEPTH;
     }
 
-    int searchDepth = (depth > 0) ? depth : 64;
-    Board boardCopy = board;  // snapshot so position commands don't race
+    {
+        std::lock_guard<std::mutex> lock(searchMutex);
+        job.board        = board;  // snapshot so position commands don't race
+        job.depth        = (depth > 0) ? depth : 64;
+        job.perft        = false;
+        holdBestMove     = infinite || ponder;
+        pondering        = ponder;
+        stopRequested    = false;
+        jobPending       = true;
+        searching        = true;
+    }
+    searchCv.notify_all();
+}
 
-    searchThread = std::thread([this, boardCopy, searchDepth, infinite]() mutable {
-        SearchResult result = search.search(boardCopy, searchDepth);
-        // UCI: in infinite mode bestmove must not be sent until "stop"
-        if (infinite) {
-            while (!stopRequested.load())
-                std::this_thread::sleep_for(std::chrono::milliseconds(5));
-        }
-        sendBestMove(result.bestMove);
-    });
+void UCIEngine::runPerft(const Board& start, int depth) {
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    auto results = Perft::divide(start, depth, threads, 16, &stopRequested);
+    OutputLine line;
+    if (stopRequested) {
+        line << "info string perft stopped";
+        line.send();
+        return;
+    }
+    uint64_t total = 0;
+    for (const auto& entry : results) {
+        line << entry.first << ": " << entry.second;
+        line.send();
+        total += entry.second;
+    }
+    line.send();
+    line << "Nodes searched: " << total;
+    line.send();
 }
 
 void UCIEngine::handleStop() {
-    stopRequested = true;
-    if (searchThread.joinable()) searchThread.join();
+    stopSearch();
+}
+
+// The opponent played the predicted move: the ponder search carries on as
+// a normal timed search, its clock starting now
+void UCIEngine::handlePonderHit() {
+    std::lock_guard<std::mutex> lock(searchMutex);
+    pondering    = false;
+    holdBestMove = false;
+    searchCv.notify_all();
 }
 
 void UCIEngine::handleQuit() {
-    stopRequested = true;
-    if (searchThread.joinable()) searchThread.join();
+    stopSearch();
     isRunning = false;
 }
 
@@ -302,11 +549,12 @@ Move UCIEngine::parseMove(const std::string& moveStr) {
     return move;
 }
 
-void UCIEngine::sendBestMove(const Move& move) {
+void UCIEngine::sendBestMove(const Move& move, const Move& ponder) {
     // No legal move (mate/stalemate): UCI convention is "bestmove 0000"
-    if (move.from == move.to)
-        std::cout << "bestmove 0000" << std::endl;
-    else
-        std::cout << "bestmove " << moveToUci(move) << std::endl;
+    OutputLine line;
+    if (move.from == move.to) line << "bestmove 0000";
+    else                      line << "bestmove " << move;
+    if (move.from != move.to && ponder.from != ponder.to) line << " ponder " << ponder;
+    line.send();
 }
 
@@ -2,8 +2,12 @@
 #define UCI_H
 
 #include "board.h"
+#include "options.h"
 #include "search.h"
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
@@ -13,8 +17,49 @@ private:
     Board board;
     SearchEngine search;
     bool isRunning;
+    std::thread bookThread;  // loads the opening book at startup
+
+    // Advertised in the uci reply; the callbacks apply changes to the
+    // members below and to the search
+    OptionRegistry options;
+    int moveOverhead = 100;  // ms kept back from the clock for lag
+    bool ownBook = true;
+
+    // What the last "position" command set up: its start ("startpos" or
+    // the FEN) and the moves actually applied to board. A command that
+    // repeats them and appends moves only has the new ones applied.
+    std::string positionStart;
+    std::vector<std::string> positionMoves;
+
+    // One search thread for the engine's lifetime, woken per "go". The
+    // command loop hands it a job under searchMutex; "stop" and "ponderhit"
+    // are signalled through the atomics and searchCv.
+    struct SearchJob {
+        Board board;
+        int depth = 0;
+        bool perft = false;  // go perft: leaf counts, no bestmove
+    };
     std::thread searchThread;
+    std::mutex searchMutex;
+    std::condition_variable searchCv;
+    SearchJob job;
+    bool jobPending = false;    // a go the worker has not picked up yet
+    bool searching = false;     // worker busy, until its bestmove is sent
+    bool holdBestMove = false;  // infinite/ponder: bestmove waits for stop or ponderhit
+    bool workerExit = false;
     std::atomic<bool> stopRequested{false};
+    std::atomic<bool> pondering{false};
+
+    // stdin is read on its own thread into a queue the command loop drains.
+    // stop, ponderhit and quit also act on the running search the moment
+    // they are read, even while the loop is busy (book load, TT clear, a long
+    // position); they are queued too, so they keep their order relative to
+    // a go that has not started yet.
+    std::thread inputThread;
+    std::mutex inputMutex;
+    std::condition_variable inputCv;
+    std::deque<std::string> commands;
+    bool inputClosed = false;  // EOF or quit read
     
 public:
     // exePath (argv[0]) is used to locate eco.pgn next to the executable
@@ -34,14 +79,27 @@ private:
     void handleNewGame();
     void handlePosition(const std::vector<std::string>& tokens);
     void handleGo(const std::vector<std::string>& tokens);
+    void handleSetOption(const std::vector<std::string>& tokens);
     void handleStop();
+    void handlePonderHit();
     void handleQuit();
+
+    void registerOptions();
+    // Blocks until the startup book load is done; command loop only
+    void waitForBook();
+    void searchLoop();
+    void runPerft(const Board& board, int depth);  // search thread
+    void inputLoop();
+    // Asks the running search to finish without waiting for its bestmove
+    void interruptSearch();
+    // Stops the current search, if any, and waits until its bestmove is out
+    void stopSearch();
     
     // Utility functions
     std::vector<std::string> split(const std::string& str, char delimiter = ' ');
     Move parseMove(const std::string& moveStr);
     bool tryApplyMove(const std::string& moveStr);
-    void sendBestMove(const Move& move);
+    void sendBestMove(const Move& move, const Move& ponder);
 };
 
 #endif // UCI_H
\ No newline at end of file
@@ -0,0 +1,82 @@
+// C API test: drives libchess_engine only through src/chess_engine.h -
+// positions from FEN and moves, perft, evaluation and a callback search -
+// and runs several handles on separate threads at once to check that they
+// do not share state.
+#include "chess_engine.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    int failures = 0;
+
+    void check(bool ok, const char* what) {
+        if (!ok) {
+            std::printf("FAIL %s\n", what);
+            failures++;
+        }
+    }
+
+    void countIterations(const ce_search_info* info, void* userData) {
+        int* iterations = static_cast<int*>(userData);
+        if (info->depth == *iterations + 1 && std::strlen(info->best_move) >= 4) ++*iterations;
+    }
+}
+
+int main() {
+    ce_engine* engine = ce_create(8);
+    check(engine != nullptr, "create");
+
+    char fen[128];
+    check(ce_set_position(engine, nullptr, "e2e4 e7e5 g1f3") == CE_OK, "startpos moves");
+    ce_get_fen(engine, fen, sizeof(fen));
+    check(std::string(fen) == "rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2",
+          "fen after moves");
+    check(ce_set_position(engine, nullptr, "e2e4 e2e4") == CE_ILLEGAL_MOVE, "illegal move");
+    check(ce_set_position(engine, "not a fen", nullptr) == CE_INVALID_FEN, "invalid fen");
+    ce_get_fen(engine, fen, sizeof(fen));
+    check(std::string(fen).rfind("rnbqkbnr/pppp1ppp", 0) == 0, "failed set keeps position");
+
+    ce_set_position(engine, "startpos", nullptr);
+    check(ce_perft(engine, 4, 1) == 197281, "perft 4");
+    check(ce_evaluate(engine) == 0, "startpos evaluates to 0");
+
+    // Mate in one for white; side-to-move score
+    ce_set_position(engine, "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1", nullptr);
+    ce_limits limits = {4, 0, 0};
+    ce_search_result result;
+    int iterations = 0;
+    check(ce_search(engine, &limits, countIterations, &iterations, &result) == CE_OK, "search");
+    check(std::string(result.best_move) == "a1a8", "mate move");
+    check(result.score == CE_MATE_SCORE - 1, "mate score");
+    check(iterations >= 1, "info callback");
+
+    // Independent handles searching concurrently agree with a lone search
+    const char* position = "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3";
+    ce_set_position(engine, position, nullptr);
+    ce_new_game(engine);
+    limits.depth = 6;
+    ce_search_result reference;
+    ce_search(engine, &limits, nullptr, nullptr, &reference);
+
+    std::vector<ce_search_result> results(4);
+    std::vector<std::thread> threads;
+    for (ce_search_result& r : results) {
+        threads.emplace_back([&r, position, limits] {
+            ce_engine* handle = ce_create(8);
+            ce_set_position(handle, position, nullptr);
+            ce_search(handle, &limits, nullptr, nullptr, &r);
+            ce_destroy(handle);
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    for (const ce_search_result& r : results)
+        check(std::strcmp(r.best_move, reference.best_move) == 0 && r.nodes == reference.nodes,
+              "concurrent handle matches lone search");
+
+    ce_destroy(engine);
+    if (failures == 0) std::printf("c_api: all checks passed\n");
+    return failures == 0 ? 0 : 1;
+}
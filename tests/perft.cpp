@@ -1,8 +1,11 @@
 // Perft test: counts leaf nodes of the legal move tree and compares against
 // published reference values. Any mismatch means a move generation or
-// make/unmake bug.
+// make/unmake bug. Each case is counted twice: by a plain make/unmake
+// recursion, and through Perft with two threads and a hash table so the
+// root split and the perft hash are checked as well.
 #include "board.h"
 #include "movegen.h"
+#include "perft.h"
 #include <cstdint>
 #include <cstdio>
 #include <string>
@@ -73,6 +76,15 @@ int main() {
                         (unsigned long long)c.expected, (unsigned long long)got);
             failures++;
         }
+
+        uint64_t threaded = Perft::count(board, c.depth, 2, 16);
+        if (threaded == c.expected) {
+            std::printf("ok   %-12s %llu (threaded, hashed)\n", c.name, (unsigned long long)threaded);
+        } else {
+            std::printf("FAIL %-12s expected %llu got %llu (threaded, hashed)\n", c.name,
+                        (unsigned long long)c.expected, (unsigned long long)threaded);
+            failures++;
+        }
     }
 
     if (failures) {
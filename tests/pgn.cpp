@@ -0,0 +1,114 @@
+// PGN test: every legal move in the trees of the perft positions must come
+// back unchanged from PgnReader::resolveMove, written both as SAN and as
+// UCI coordinates, and a small PGN with tags, comments, variations, NAGs and
+// a header-less game must read as the expected games.
+#include "board.h"
+#include "movegen.h"
+#include "notation.h"
+#include "pgn.h"
+#include <cstdio>
+#include <string>
+
+static bool sameMove(const Move& a, const Move& b) {
+    return a.from == b.from && a.to == b.to && a.promotion == b.promotion &&
+           a.isCapture == b.isCapture && a.isCastle == b.isCastle && a.isEnPassant == b.isEnPassant;
+}
+
+// Resolves every legal move to the given depth; returns the mismatch count
+static int checkTree(Board& board, int depth, long long& checked) {
+    MoveList legal;
+    MoveGenerator::generateLegalMoves(board, legal);
+    int failures = 0;
+    for (const Move& m : legal) {
+        std::string san = Notation::toSan(board, m);
+        std::string uci = moveToUci(m);
+        checked++;
+        if (!sameMove(PgnReader::resolveMove(board, san), m) ||
+            !sameMove(PgnReader::resolveMove(board, uci), m)) {
+            if (failures++ < 5)
+                std::printf("FAIL %s / %s in %s\n", san.c_str(), uci.c_str(), board.toFEN().c_str());
+        }
+        if (depth > 1) {
+            board.makeMove(m);
+            failures += checkTree(board, depth - 1, checked);
+            board.unmakeMove(m);
+        }
+    }
+    return failures;
+}
+
+int main() {
+    static const char* fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    };
+
+    int failures = 0;
+    for (const char* fen : fens) {
+        Board board;
+        board.fromFEN(fen);
+        long long checked = 0;
+        int bad = checkTree(board, 3, checked);
+        std::printf("%-4s %lld moves resolved in %s\n", bad ? "FAIL" : "ok", checked, fen);
+        failures += bad;
+    }
+
+    // Moves that must not resolve: a pinned piece, unreachable squares, a
+    // promotion without a piece, castling through pieces, garbage
+    auto rejected = [](const char* fen, const char* text) {
+        Board board;
+        board.fromFEN(fen);
+        Move m = PgnReader::resolveMove(board, text);
+        return m.from == m.to;
+    };
+    const char* start = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    bool ok = rejected("4k3/4r3/8/8/8/8/4N3/4K3 w - - 0 1", "Nc3") &&
+              rejected("4k3/8/8/8/8/8/4P3/4K3 w - - 0 1", "e8") &&
+              rejected("4k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a8") &&
+              rejected(start, "Nd2") && rejected(start, "e5") &&
+              rejected(start, "Rh3") && rejected(start, "xyz") && rejected(start, "O-O");
+    std::printf("%-4s illegal and malformed moves rejected\n", ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+
+    const char* text =
+        "[Event \"test\"]\n"
+        "[White \"A\"]\n"
+        "\n"
+        "1. e4 $1 e5 {a comment\n"
+        "[not a tag]} 2. Nf3 (2. f4 exf4 (2... d5)) 2...Nc6 ; rest of line\n"
+        "3.Bb5 a6 1-0\n"
+        "\n"
+        "[Event \"second\"]\n"
+        "[FEN \"4k3/8/8/8/8/8/8/4K3 w - - 0 1\"]\n"
+        "\n"
+        "1. Kd2 *\n"
+        "\n"
+        "1. d4 $12 d5 $7\n"
+        "\n"
+        "1. c4\n";
+    PgnReader reader(text);
+    PgnGame game;
+    std::string got;
+    int games = 0;
+    while (reader.next(game)) {
+        games++;
+        got += std::string(game.tag("Event")) + ":";
+        for (const PgnMove& m : game.moves)
+            got += " " + std::string(m.text) + (m.nag >= 0 ? "$" + std::to_string(m.nag) : "");
+        got += " [" + std::string(game.result) + "]\n";
+    }
+    const char* expected =
+        "test: e4$1 e5 Nf3 Nc6 Bb5 a6 [1-0]\n"
+        "second: Kd2 [*]\n"
+        ": d4$12 d5$7 []\n"
+        ": c4 []\n";
+    ok = games == 4 && got == expected;
+    std::printf("%-4s reading games, tags, comments and variations\n", ok ? "ok" : "FAIL");
+    if (!ok) { std::printf("%s", got.c_str()); failures++; }
+
+    std::printf("%s\n", failures ? "FAILED" : "all passed");
+    return failures ? 1 : 0;
+}
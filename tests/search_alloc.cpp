@@ -0,0 +1,65 @@
+// Allocation test: the search keeps its per-ply state in preallocated
+// frames, so the number of heap allocations during a search must not grow
+// with the number of nodes. Counts calls to the global operator new while
+// searching a handful of positions and fails if any search allocates more
+// than a small fixed amount (root move list, board copy).
+//
+// No tablebases are loaded, so the probes alphaBeta makes inside tablebase
+// range (Tablebases::probeWDL) are not covered here.
+#include "board.h"
+#include "search.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<long> allocations{0};
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main() {
+    static const char* fens[] = {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    };
+    const long MAX_PER_SEARCH = 16;
+
+    SearchEngine engine;
+    engine.setQuietMode(true);
+    engine.setTimeLimit(0);
+
+    // Warm up one-time lazy initialization (endgame registry etc.)
+    Board warmup;
+    engine.search(warmup, 2);
+
+    int failures = 0;
+    for (const char* fen : fens) {
+        Board board;
+        board.fromFEN(fen);
+        engine.newGame();
+
+        long before = allocations.load();
+        SearchResult result = engine.search(board, 7);
+        long used = allocations.load() - before;
+
+        bool ok = used <= MAX_PER_SEARCH && result.nodesSearched > 1000;
+        std::printf("%s %-72s nodes %d allocations %ld\n", ok ? "ok  " : "FAIL",
+                    fen, result.nodesSearched, used);
+        if (!ok) failures++;
+    }
+
+    if (failures) {
+        std::printf("%d search(es) allocated per node\n", failures);
+        return 1;
+    }
+    std::printf("search allocations bounded\n");
+    return 0;
+}
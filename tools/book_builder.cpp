@@ -0,0 +1,206 @@
+// Builds a Polyglot .bin opening book from local PGN databases: every
+// main-line move of every game up to --max-ply is counted per position, moves
+// seen fewer than --min-count times are dropped, and the counts become the
+// entry weights. Load the result with "setoption name BookFile value ...".
+//
+//   book_builder <out.bin> <games.pgn>... [--max-ply N] [--min-count N]
+//                [--min-elo N] [--threads N]
+//
+// Each file is memory-mapped and cut at game boundaries into shards that the
+// threads read in parallel; the counts go into a lock-striped hash map.
+#include "board.h"
+#include "mapped_file.h"
+#include "pgn.h"
+#include "polyglot.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    struct MoveCount {
+        uint16_t move;  // Polyglot encoding
+        uint32_t count;
+    };
+
+    // Position key -> move counts, split into independently locked stripes
+    // by the key's top bits so threads rarely wait on each other
+    class CountMap {
+    public:
+        static constexpr int STRIPES = 256;
+
+        void add(uint64_t key, uint16_t move) {
+            Stripe& s = stripes[key >> 56];
+            std::lock_guard<std::mutex> lock(s.mutex);
+            std::vector<MoveCount>& moves = s.positions[key];
+            for (MoveCount& m : moves)
+                if (m.move == move) { m.count++; return; }
+            moves.push_back({move, 1});
+        }
+
+        // Visits every position; not thread-safe with add()
+        template <typename F> void forEach(F f) const {
+            for (const Stripe& s : stripes)
+                for (const auto& position : s.positions) f(position.first, position.second);
+        }
+
+    private:
+        struct Stripe {
+            std::mutex mutex;
+            std::unordered_map<uint64_t, std::vector<MoveCount>> positions;
+        };
+        Stripe stripes[STRIPES];
+    };
+
+    struct Shard {
+        const MappedFile* file;
+        size_t begin, end;
+    };
+
+    struct Entry {
+        uint64_t key;
+        uint16_t move;
+        uint16_t weight;
+    };
+
+    void writeBE(unsigned char* p, uint64_t value, int bytes) {
+        for (int i = bytes - 1; i >= 0; i--, value >>= 8) p[i] = static_cast<unsigned char>(value);
+    }
+
+    int tagInt(const PgnGame& game, const char* name) {
+        std::string value(game.tag(name));
+        return value.empty() ? 0 : std::atoi(value.c_str());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string out;
+    std::vector<std::string> inputs;
+    int maxPly = 24, minCount = 3, minElo = 0;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--max-ply") && hasValue)        maxPly = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--min-count") && hasValue) minCount = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--min-elo") && hasValue)   minElo = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--threads") && hasValue)   threads = std::max(1, std::atoi(argv[++i]));
+        else if (out.empty())                                      out = argv[i];
+        else                                                       inputs.push_back(argv[i]);
+    }
+    if (out.empty() || inputs.empty()) {
+        std::fprintf(stderr, "usage: %s <out.bin> <games.pgn>... [--max-ply N] [--min-count N] "
+                             "[--min-elo N] [--threads N]\n", argv[0]);
+        return 2;
+    }
+
+    // About eight shards per thread and file, so a slow shard near the end
+    // does not leave the other threads idle
+    std::vector<std::unique_ptr<MappedFile>> files;
+    std::vector<Shard> shards;
+    for (const std::string& path : inputs) {
+        files.push_back(std::make_unique<MappedFile>());
+        MappedFile& file = *files.back();
+        if (!file.open(path)) {
+            std::fprintf(stderr, "cannot read %s\n", path.c_str());
+            return 2;
+        }
+        std::string_view data = file.view();
+        size_t pieces = static_cast<size_t>(threads) * 8;
+        size_t begin = 0;
+        for (size_t i = 1; i <= pieces && begin < data.size(); i++) {
+            size_t end = i == pieces ? data.size()
+                                     : PgnReader::nextGameStart(data, data.size() / pieces * i);
+            if (end > begin) shards.push_back({&file, begin, end});
+            begin = std::max(begin, end);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    CountMap counts;
+    std::atomic<size_t> nextShard{0};
+    std::atomic<long long> gamesRead{0}, gamesUsed{0}, movesCounted{0};
+
+    auto worker = [&] {
+        PgnGame game;
+        long long read = 0, used = 0, counted = 0;
+        for (size_t i = nextShard++; i < shards.size(); i = nextShard++) {
+            const Shard& shard = shards[i];
+            PgnReader reader(shard.file->view().substr(shard.begin, shard.end - shard.begin));
+            while (reader.next(game)) {
+                read++;
+                if (minElo && (tagInt(game, "WhiteElo") < minElo || tagInt(game, "BlackElo") < minElo))
+                    continue;
+                Board board;
+                std::string_view fen = game.tag("FEN");
+                if (!fen.empty() && !board.fromFEN(std::string(fen))) continue;
+                used++;
+                int ply = 0;
+                for (const PgnMove& m : game.moves) {
+                    if (ply++ >= maxPly) break;
+                    Move move = PgnReader::resolveMove(board, m.text);
+                    if (move.from == move.to) break;
+                    counts.add(PolyglotBook::key(board), PolyglotBook::encodeMove(move));
+                    board.makeMove(move);
+                    counted++;
+                }
+            }
+        }
+        gamesRead += read;
+        gamesUsed += used;
+        movesCounted += counted;
+    };
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) pool.emplace_back(worker);
+    for (std::thread& t : pool) t.join();
+
+    // Polyglot weights are 16 bits and only relative within a position, so
+    // a position whose top count does not fit is scaled down
+    std::vector<Entry> entries;
+    size_t positions = 0;
+    counts.forEach([&](uint64_t key, const std::vector<MoveCount>& moves) {
+        uint32_t top = 0;
+        for (const MoveCount& m : moves)
+            if (m.count >= static_cast<uint32_t>(minCount)) top = std::max(top, m.count);
+        if (!top) return;
+        positions++;
+        for (const MoveCount& m : moves) {
+            if (m.count < static_cast<uint32_t>(minCount)) continue;
+            uint64_t weight = top > 65535 ? std::max<uint64_t>(1, uint64_t{m.count} * 65535 / top) : m.count;
+            entries.push_back({key, m.move, static_cast<uint16_t>(weight)});
+        }
+    });
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        if (a.key != b.key) return a.key < b.key;
+        if (a.weight != b.weight) return a.weight > b.weight;
+        return a.move < b.move;
+    });
+
+    FILE* f = std::fopen(out.c_str(), "wb");
+    if (!f) {
+        std::fprintf(stderr, "cannot write %s\n", out.c_str());
+        return 1;
+    }
+    for (const Entry& e : entries) {
+        unsigned char record[16] = {};  // key, move, weight, learn (unused)
+        writeBE(record, e.key, 8);
+        writeBE(record + 8, e.move, 2);
+        writeBE(record + 10, e.weight, 2);
+        std::fwrite(record, 1, sizeof(record), f);
+    }
+    bool ok = std::fclose(f) == 0;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%lld games read, %lld used, %lld moves counted in %.2f s (%.0f games/s, %d threads)\n",
+                gamesRead.load(), gamesUsed.load(), movesCounted.load(), seconds,
+                seconds > 0 ? gamesRead.load() / seconds : 0.0, threads);
+    std::printf("%zu entries in %zu positions written to %s\n", entries.size(), positions, out.c_str());
+    return ok ? 0 : 1;
+}
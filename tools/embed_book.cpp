@@ -0,0 +1,58 @@
+// Compiles a PGN opening book into src/eco_book.cpp: the positions and
+// weights OpeningBook builds from the PGN, written out in its flat sorted
+// layout (keys, offsets, moves) for the engine to search in place.
+//
+//   embed_book [book.pgn] [out.cpp]      (defaults src/eco.pgn, src/eco_book.cpp)
+//
+// Normally run through scripts/embed_book.py.
+#include "opening_book.h"
+#include <cinttypes>
+#include <cstdio>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    std::string pgn = argc > 1 ? argv[1] : "src/eco.pgn";
+    std::string out = argc > 2 ? argv[2] : "src/eco_book.cpp";
+
+    OpeningBook book;
+    if (!book.loadFromFile(pgn)) {
+        std::fprintf(stderr, "cannot read a book from %s\n", pgn.c_str());
+        return 1;
+    }
+    const OpeningBook::Table& table = book.table();
+    size_t moves = table.offsets[table.positions];
+
+    FILE* f = std::fopen(out.c_str(), "w");
+    if (!f) {
+        std::fprintf(stderr, "cannot write %s\n", out.c_str());
+        return 1;
+    }
+    std::string source = pgn.substr(pgn.find_last_of("/\\") + 1);
+    std::fprintf(f, "// Generated by tools/embed_book from %s — do not edit by hand.\n"
+                    "// Regenerate with scripts/embed_book.py.\n"
+                    "#include \"eco_book.h\"\n\n", source.c_str());
+
+    std::fprintf(f, "const uint64_t ECO_BOOK_KEYS[] = {\n");
+    for (size_t i = 0; i < table.positions; i++)
+        std::fprintf(f, "%s0x%016" PRIx64 "ULL,%s", i % 4 ? " " : "    ", table.keys[i],
+                     i % 4 == 3 ? "\n" : "");
+    std::fprintf(f, "%s};\n\n", table.positions % 4 ? "\n" : "");
+
+    std::fprintf(f, "const uint32_t ECO_BOOK_OFFSETS[] = {\n");
+    for (size_t i = 0; i <= table.positions; i++)
+        std::fprintf(f, "%s%" PRIu32 ",%s", i % 10 ? " " : "    ", table.offsets[i],
+                     i % 10 == 9 ? "\n" : "");
+    std::fprintf(f, "%s};\n\n", (table.positions + 1) % 10 ? "\n" : "");
+
+    // {weight, move}
+    std::fprintf(f, "const BookMove ECO_BOOK_MOVES[] = {\n");
+    for (size_t i = 0; i < moves; i++)
+        std::fprintf(f, "%s{%" PRIu32 ", 0x%04x},%s", i % 6 ? " " : "    ", table.moves[i].weight,
+                     static_cast<unsigned>(table.moves[i].move), i % 6 == 5 ? "\n" : "");
+    std::fprintf(f, "%s};\n\n", moves % 6 ? "\n" : "");
+
+    std::fprintf(f, "const std::size_t ECO_BOOK_POSITIONS = %zu;\n", table.positions);
+    bool ok = std::fclose(f) == 0;
+    std::printf("%zu moves in %zu positions written to %s\n", moves, table.positions, out.c_str());
+    return ok ? 0 : 1;
+}
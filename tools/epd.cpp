@@ -0,0 +1,231 @@
+// Test-suite runner: searches every position of an EPD file (WAC, STS,
+// ...) and checks the engine's move against the bm / am operations.
+//
+//   epd <file.epd> [--time MS | --depth N | --nodes N] [--threads N] [--hash MB]
+//
+// Default limit: 1000 ms per position. Each thread owns an independent
+// SearchEngine, cleared before every position. A position counts as solved
+// when the final move is a best move (and not an avoid move); its time
+// and nodes to solution are taken from the first iteration after which the
+// answer never changed again, so a faster search shows up as earlier
+// solutions and not only as higher nps. Exits with 1 unless every
+// position was solved.
+#include "board.h"
+#include "notation.h"
+#include "pgn.h"
+#include "search.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    struct Test {
+        std::string fen, id;
+        std::vector<std::string> best, avoid;   // SAN as written in the file
+    };
+
+    struct Outcome {
+        bool done = false, solved = false;
+        std::string played;
+        int depth = 0;
+        long long timeMs = 0, nodes = 0;        // whole search
+        int solvedDepth = 0;
+        long long solvedMs = 0, solvedNodes = 0;  // to solution
+    };
+
+    std::string trim(const std::string& s) {
+        size_t b = s.find_first_not_of(" \t\r\n"), e = s.find_last_not_of(" \t\r\n");
+        return b == std::string::npos ? "" : s.substr(b, e - b + 1);
+    }
+
+    // Four FEN fields, then operations: "bm Qd1+ Nf3; id "WAC.001";"
+    bool parseEpd(const std::string& line, Test& test) {
+        std::istringstream iss(line);
+        std::string f[4];
+        for (std::string& field : f)
+            if (!(iss >> field)) return false;
+        test.fen = f[0] + " " + f[1] + " " + f[2] + " " + f[3] + " 0 1";
+
+        std::string rest;
+        std::getline(iss, rest);
+        std::stringstream ops(rest);
+        std::string op;
+        while (std::getline(ops, op, ';')) {
+            op = trim(op);
+            size_t space = op.find(' ');
+            if (space == std::string::npos) continue;
+            std::string code = op.substr(0, space), operand = trim(op.substr(space + 1));
+            if (code == "id") {
+                test.id = operand;
+                test.id.erase(std::remove(test.id.begin(), test.id.end(), '"'), test.id.end());
+            } else if (code == "bm" || code == "am") {
+                std::istringstream moves(operand);
+                std::string m;
+                while (moves >> m) (code == "bm" ? test.best : test.avoid).push_back(m);
+            }
+        }
+        return !test.best.empty() || !test.avoid.empty();
+    }
+
+    bool sameMove(const Move& a, const Move& b) {
+        return a.from == b.from && a.to == b.to && a.promotion == b.promotion;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <file.epd> [--time MS | --depth N | --nodes N] [--threads N] [--hash MB]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    int timeMs = 0, depth = 0, nodes = 0, hashMB = 16;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 2; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--time") && hasValue)         timeMs = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--depth") && hasValue)   depth = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--nodes") && hasValue)   nodes = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--threads") && hasValue) threads = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--hash") && hasValue)    hashMB = std::atoi(argv[++i]);
+    }
+    if (!timeMs && !depth && !nodes) timeMs = 1000;
+
+    std::vector<Test> tests;
+    std::ifstream file(argv[1]);
+    if (!file) {
+        std::fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 2;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        Test test;
+        if (parseEpd(line, test)) {
+            if (test.id.empty()) test.id = "#" + std::to_string(tests.size() + 1);
+            tests.push_back(test);
+        }
+    }
+    if (tests.empty()) {
+        std::fprintf(stderr, "no bm/am positions in %s\n", argv[1]);
+        return 2;
+    }
+    threads = std::min<int>(threads, static_cast<int>(tests.size()));
+
+    std::vector<Outcome> outcomes(tests.size());
+    std::atomic<size_t> next{0};
+    std::mutex mutex;
+    size_t printed = 0;
+
+    // Results are printed in file order as soon as they are available
+    auto report = [&] {
+        while (printed < tests.size() && outcomes[printed].done) {
+            const Test& t = tests[printed];
+            const Outcome& o = outcomes[printed];
+            std::string expected;
+            for (const std::string& m : t.best)  expected += (expected.empty() ? "bm " : " ") + m;
+            for (const std::string& m : t.avoid) expected += (expected.empty() ? "am " : " am ") + m;
+            if (o.solved)
+                std::printf("ok    %-16s %-8s %-16s depth %2d  time %6lld ms  nodes %10lld\n",
+                            t.id.c_str(), o.played.c_str(), expected.c_str(),
+                            o.solvedDepth, o.solvedMs, o.solvedNodes);
+            else
+                std::printf("FAIL  %-16s %-8s %-16s depth %2d\n",
+                            t.id.c_str(), o.played.c_str(), expected.c_str(), o.depth);
+            std::fflush(stdout);
+            printed++;
+        }
+    };
+
+    auto worker = [&] {
+        SearchEngine engine;
+        engine.setHashSize(hashMB);
+        engine.setQuietMode(true);
+        for (size_t i = next++; i < tests.size(); i = next++) {
+            const Test& t = tests[i];
+            Outcome o;
+            Board board;
+            if (!board.fromFEN(t.fen)) {
+                std::lock_guard<std::mutex> lock(mutex);
+                outcomes[i].done = true;
+                report();
+                continue;
+            }
+
+            std::vector<Move> best, avoid;
+            for (const std::string& m : t.best)  best.push_back(PgnReader::resolveMove(board, m));
+            for (const std::string& m : t.avoid) avoid.push_back(PgnReader::resolveMove(board, m));
+            auto correct = [&](const Move& m) {
+                bool inBest = best.empty() ||
+                              std::any_of(best.begin(), best.end(), [&](const Move& b) { return sameMove(b, m); });
+                bool inAvoid = std::any_of(avoid.begin(), avoid.end(), [&](const Move& a) { return sameMove(a, m); });
+                return inBest && !inAvoid;
+            };
+
+            bool streak = false;
+            engine.setInfoCallback([&](const SearchInfo& info) {
+                bool ok = correct(info.bestMove);
+                if (ok && !streak) {
+                    o.solvedDepth = info.depth;
+                    o.solvedMs    = info.timeMs;
+                    o.solvedNodes = info.nodes;
+                }
+                streak = ok;
+            });
+
+            engine.newGame();
+            engine.setTimeLimit(timeMs);
+            engine.setSoftTimeLimit(timeMs);
+            engine.setNodeLimit(nodes);
+            auto start = std::chrono::steady_clock::now();
+            SearchResult r = engine.search(board, depth > 0 ? depth : 64);
+            o.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start).count();
+
+            o.played = r.bestMove.from != r.bestMove.to ? Notation::toSan(board, r.bestMove) : "-";
+            o.depth  = r.depth;
+            o.nodes  = r.nodesSearched;
+            // A move found without a completed iteration (only move) counts
+            // as solved at once
+            o.solved = r.bestMove.from != r.bestMove.to && correct(r.bestMove);
+            if (o.solved && !streak) o.solvedDepth = o.solvedMs = o.solvedNodes = 0;
+            o.done = true;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            outcomes[i] = o;
+            report();
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int solved = 0;
+    long long solvedMs = 0, solvedNodes = 0, totalNodes = 0;
+    for (const Outcome& o : outcomes) {
+        totalNodes += o.nodes;
+        if (!o.solved) continue;
+        solved++;
+        solvedMs += o.solvedMs;
+        solvedNodes += o.solvedNodes;
+    }
+    std::printf("\nSolved            : %d / %zu\n", solved, tests.size());
+    std::printf("Time to solution  : %lld ms total, %.0f ms mean\n", solvedMs,
+                solved ? static_cast<double>(solvedMs) / solved : 0.0);
+    std::printf("Nodes to solution : %lld total, %.0f mean\n", solvedNodes,
+                solved ? static_cast<double>(solvedNodes) / solved : 0.0);
+    std::printf("Nodes searched    : %lld in %.1f s (%d threads)\n", totalNodes, secs, threads);
+    return solved == static_cast<int>(tests.size()) ? 0 : 1;
+}
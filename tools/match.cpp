@@ -0,0 +1,786 @@
+// Engine-versus-engine matches for testing a change: two UCI engines (two
+// builds, or one build under two option sets) play every opening with both
+// colours, many games at once, and the result is reported as an Elo
+// difference with 95% error bars and an optional SPRT.
+//
+//   match --engine cmd=PATH [name=NAME] [option.NAME=VALUE ...]
+//         --engine cmd=PATH [name=NAME] [option.NAME=VALUE ...]
+//         [--openings FILE.epd|FILE.pgn] [--plies N] [--games N]
+//         [--concurrency N] [--tc BASE+INC] [--margin MS] [--maxplies N]
+//         [--draw movenumber=40 movecount=8 score=10]
+//         [--resign movecount=4 score=1000]
+//         [--sprt elo0=0 elo1=5 alpha=0.05 beta=0.05] [--pgn FILE]
+//
+// The time control is in seconds (10+0.1). Results are from the first
+// engine's point of view. Each worker thread keeps its own pair of engine
+// processes for all of its games, so concurrency defaults to the number of
+// hardware threads. A movecount of 0 turns an adjudication rule off.
+#include "board.h"
+#include "movegen.h"
+#include "mapped_file.h"
+#include "notation.h"
+#include "pgn.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    const std::string START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    struct EngineConfig {
+        std::string name;
+        std::string command;
+        std::vector<std::pair<std::string, std::string>> options;
+    };
+
+    struct Opening {
+        std::string fen;
+        std::vector<std::string> moves;  // UCI, played before the engines take over
+    };
+
+    struct Settings {
+        double baseMs = 10000, incMs = 100;
+        std::string tcLabel = "10+0.1";
+        int marginMs = 50;
+        int maxPlies = 400;
+        int drawMoveNumber = 40, drawMoveCount = 8, drawScore = 10;
+        int resignMoveCount = 4, resignScore = 1000;
+        bool sprt = false;
+        double elo0 = 0, elo1 = 5, alpha = 0.05, beta = 0.05;
+    };
+
+    // ---------------------------------------------------------------------
+    // Engine processes
+    // ---------------------------------------------------------------------
+
+    // Games start engines concurrently, so every pipe is close-on-exec:
+    // otherwise each child would inherit the other games' pipe ends and keep
+    // a crashed engine's stdout open (no EOF). dup2 clears the flag on the
+    // child's stdin and stdout.
+    bool makePipe(int fds[2]) {
+#ifdef __APPLE__
+        // No pipe2 on macOS; setting the flag right after narrows the race
+        if (pipe(fds) != 0) return false;
+        fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+        fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+        return true;
+#else
+        return pipe2(fds, O_CLOEXEC) == 0;
+#endif
+    }
+
+    // A UCI engine running as a child process, spoken to over pipes
+    class EngineProcess {
+    public:
+        ~EngineProcess() { stop(); }
+
+        bool running() const { return pid > 0; }
+
+        bool start(const EngineConfig& config) {
+            // Built before fork(): the child of a multithreaded process may
+            // only make async-signal-safe calls, so no allocation there
+            std::string command = "exec " + config.command;
+
+            int toChild[2], fromChild[2];
+            if (!makePipe(toChild)) return false;
+            if (!makePipe(fromChild)) {
+                close(toChild[0]); close(toChild[1]);
+                return false;
+            }
+
+            pid = fork();
+            if (pid < 0) {
+                close(toChild[0]); close(toChild[1]);
+                close(fromChild[0]); close(fromChild[1]);
+                return false;
+            }
+            if (pid == 0) {
+                dup2(toChild[0], STDIN_FILENO);
+                dup2(fromChild[1], STDOUT_FILENO);
+                close(toChild[0]); close(toChild[1]);
+                close(fromChild[0]); close(fromChild[1]);
+                execl("/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>(nullptr));
+                _exit(127);
+            }
+            close(toChild[0]);
+            close(fromChild[1]);
+            in = toChild[1];
+            out = fromChild[0];
+            buffer.clear();
+
+            send("uci");
+            if (!waitFor("uciok", 10000)) { stop(); return false; }
+            for (const auto& option : config.options)
+                send("setoption name " + option.first + " value " + option.second);
+            if (!isReady(10000)) { stop(); return false; }
+            return true;
+        }
+
+        void send(const std::string& line) {
+            if (in < 0) return;
+            std::string data = line + "\n";
+            const char* p = data.data();
+            size_t left = data.size();
+            while (left > 0) {
+                ssize_t n = write(in, p, left);
+                if (n <= 0) return;  // engine gone; the next read reports it
+                p += n;
+                left -= static_cast<size_t>(n);
+            }
+        }
+
+        // Next line of output. False at end of file or once timeoutMs passes.
+        bool readLine(std::string& line, int timeoutMs) {
+            auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+            for (;;) {
+                size_t eol = buffer.find('\n');
+                if (eol != std::string::npos) {
+                    line = buffer.substr(0, eol);
+                    buffer.erase(0, eol + 1);
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    return true;
+                }
+                if (out < 0) return false;
+
+                int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - Clock::now()).count());
+                if (remaining <= 0) return false;
+                pollfd pfd{out, POLLIN, 0};
+                int ready = poll(&pfd, 1, remaining);
+                if (ready < 0 && errno == EINTR) continue;
+                if (ready <= 0) return false;
+
+                char chunk[4096];
+                ssize_t n = read(out, chunk, sizeof(chunk));
+                if (n <= 0) { eof = true; return false; }
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+        }
+
+        // Reads until a line starting with token
+        bool waitFor(const std::string& token, int timeoutMs) {
+            auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+            std::string line;
+            for (;;) {
+                int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - Clock::now()).count());
+                if (!readLine(line, std::max(remaining, 0))) return false;
+                if (line.compare(0, token.size(), token) == 0) return true;
+            }
+        }
+
+        bool isReady(int timeoutMs) {
+            send("isready");
+            return waitFor("readyok", timeoutMs);
+        }
+
+        // True once the engine has closed its output (crashed or quit)
+        bool exited() const { return eof; }
+
+        void stop() {
+            if (pid <= 0) return;
+            send("quit");
+            close(in);
+            in = -1;
+            for (int i = 0; i < 100; i++) {
+                if (waitpid(pid, nullptr, WNOHANG) == pid) { pid = -1; break; }
+                usleep(10000);
+            }
+            if (pid > 0) {
+                kill(pid, SIGKILL);
+                waitpid(pid, nullptr, 0);
+                pid = -1;
+            }
+            close(out);
+            out = -1;
+            eof = false;
+            buffer.clear();
+        }
+
+    private:
+        pid_t pid = -1;
+        int in = -1, out = -1;
+        bool eof = false;
+        std::string buffer;
+    };
+
+    // ---------------------------------------------------------------------
+    // Openings
+    // ---------------------------------------------------------------------
+
+    std::vector<std::string> splitWords(const std::string& s) {
+        std::istringstream iss(s);
+        std::vector<std::string> words;
+        std::string w;
+        while (iss >> w) words.push_back(w);
+        return words;
+    }
+
+    bool isNumber(const std::string& s) {
+        return !s.empty() && std::all_of(s.begin(), s.end(), ::isdigit);
+    }
+
+    // EPD: four FEN fields, then operations (or the move counters of a FEN)
+    bool loadEpd(const std::string& path, std::vector<Opening>& openings) {
+        std::ifstream file(path);
+        if (!file) return false;
+        std::string line;
+        while (std::getline(file, line)) {
+            std::vector<std::string> f = splitWords(line);
+            if (f.size() < 4 || line[0] == '#') continue;
+            std::string fen = f[0] + " " + f[1] + " " + f[2] + " " + f[3];
+            fen += (f.size() >= 6 && isNumber(f[4]) && isNumber(f[5])) ? " " + f[4] + " " + f[5] : " 0 1";
+            Board board;
+            if (board.fromFEN(fen)) openings.push_back({fen, {}});
+        }
+        return true;
+    }
+
+    // PGN: the main line of each game, up to maxPlies moves
+    bool loadPgn(const std::string& path, int maxPlies, std::vector<Opening>& openings) {
+        MappedFile file;
+        if (!file.open(path)) return false;
+        PgnReader reader(file.view());
+        PgnGame game;
+        while (reader.next(game)) {
+            Opening opening{START_FEN, {}};
+            std::string_view fen = game.tag("FEN");
+            if (!fen.empty()) opening.fen = std::string(fen);
+            Board board;
+            if (!board.fromFEN(opening.fen)) continue;
+            for (const PgnMove& m : game.moves) {
+                if (static_cast<int>(opening.moves.size()) >= maxPlies) break;
+                Move move = PgnReader::resolveMove(board, m.text);
+                if (move.from == move.to) break;
+                opening.moves.push_back(moveToUci(move));
+                board.makeMove(move);
+            }
+            openings.push_back(opening);
+        }
+        return true;
+    }
+
+    // ---------------------------------------------------------------------
+    // Games
+    // ---------------------------------------------------------------------
+
+    struct GameResult {
+        int whiteScore = 0;  // +1 white won, -1 black won, 0 draw
+        std::string result;
+        std::string termination;  // PGN Termination tag
+        std::string reason;
+        std::string pgn;
+    };
+
+    // Side to move's view; mate scores map far outside any cp score
+    bool parseScore(const std::string& info, int& score) {
+        std::vector<std::string> w = splitWords(info);
+        for (size_t i = 0; i + 2 < w.size(); i++) {
+            if (w[i] != "score") continue;
+            int v = std::atoi(w[i + 2].c_str());
+            if (w[i + 1] == "cp")   { score = v; return true; }
+            if (w[i + 1] == "mate") { score = v > 0 ? 100000 - v : -100000 - v; return true; }
+        }
+        return false;
+    }
+
+    std::string today() {
+        std::time_t t = std::time(nullptr);
+        char buf[16];
+        std::strftime(buf, sizeof(buf), "%Y.%m.%d", std::localtime(&t));
+        return buf;
+    }
+
+    int fullMoveNumber(const std::string& fen) {
+        std::vector<std::string> f = splitWords(fen);
+        return f.size() >= 6 ? std::max(1, std::atoi(f[5].c_str())) : 1;
+    }
+
+    class Game {
+    public:
+        Game(EngineProcess* white, EngineProcess* black, const Settings& settings)
+            : settings(settings) {
+            players[0] = white;
+            players[1] = black;
+        }
+
+        GameResult play(const Opening& opening, const std::string& whiteName,
+                        const std::string& blackName, int round) {
+            board.fromFEN(opening.fen);
+            startFen = opening.fen;
+            firstMoveNumber = moveNumber = fullMoveNumber(startFen);
+            blackStarts = board.getSideToMove() == Color::BLACK;
+            hashes.assign(1, board.getHash());
+            for (const std::string& uci : opening.moves) {
+                Move move = PgnReader::resolveMove(board, uci);
+                if (move.from == move.to) break;
+                record(move);
+            }
+
+            for (EngineProcess* p : players) {
+                p->send("ucinewgame");
+                if (!p->isReady(10000)) {
+                    Color c = (p == players[0]) ? Color::WHITE : Color::BLACK;
+                    return finish(c, "abandoned", "engine did not respond", whiteName, blackName, round);
+                }
+            }
+
+            double clock[2] = {settings.baseMs, settings.baseMs};
+            int resignCount[2] = {0, 0};
+            int drawCount = 0;
+
+            for (;;) {
+                GameResult over;
+                if (gameOver(over)) return finishWith(over, whiteName, blackName, round);
+
+                Color stm = board.getSideToMove();
+                int side = static_cast<int>(stm);
+                EngineProcess* engine = players[side];
+
+                std::string position = "position fen " + startFen;
+                if (!uciMoves.empty()) {
+                    position += " moves";
+                    for (const std::string& m : uciMoves) position += " " + m;
+                }
+                engine->send(position);
+                std::ostringstream go;
+                go << "go wtime " << static_cast<long long>(clock[0])
+                   << " btime " << static_cast<long long>(clock[1])
+                   << " winc " << static_cast<long long>(settings.incMs)
+                   << " binc " << static_cast<long long>(settings.incMs);
+                engine->send(go.str());
+
+                auto start = Clock::now();
+                std::string line, best;
+                int score = 0;
+                bool haveScore = false;
+                for (;;) {
+                    double used = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+                    int timeout = static_cast<int>(clock[side] + settings.marginMs - used) + 1;
+                    if (!engine->readLine(line, std::max(timeout, 1))) break;
+                    if (line.compare(0, 5, "info ") == 0) {
+                        haveScore |= parseScore(line, score);
+                    } else if (line.compare(0, 9, "bestmove ") == 0) {
+                        std::vector<std::string> w = splitWords(line);
+                        best = w.size() > 1 ? w[1] : "";
+                        break;
+                    }
+                }
+                double used = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+                if (best.empty()) {
+                    if (engine->exited())
+                        return finish(stm, "abandoned", "engine disconnected", whiteName, blackName, round);
+                    engine->send("stop");
+                    if (!engine->waitFor("bestmove", 1000)) engine->stop();  // restarted for the next game
+                    return finish(stm, "time forfeit", "loses on time", whiteName, blackName, round);
+                }
+                clock[side] -= used;
+                if (clock[side] < -settings.marginMs)
+                    return finish(stm, "time forfeit", "loses on time", whiteName, blackName, round);
+                clock[side] += settings.incMs;
+
+                Move move = PgnReader::resolveMove(board, best);
+                if (move.from == move.to)
+                    return finish(stm, "rules infraction", "makes an illegal move: " + best,
+                                  whiteName, blackName, round);
+                record(move);
+
+                if (!haveScore) { resignCount[side] = drawCount = 0; continue; }
+
+                // Resign: the mover's own score stays hopeless
+                if (settings.resignMoveCount > 0) {
+                    resignCount[side] = (score <= -settings.resignScore) ? resignCount[side] + 1 : 0;
+                    if (resignCount[side] >= settings.resignMoveCount)
+                        return finish(stm, "adjudication", "resigns", whiteName, blackName, round);
+                }
+
+                // Draw: both sides agree the game is level for a while
+                if (settings.drawMoveCount > 0) {
+                    drawCount = (std::abs(score) <= settings.drawScore) ? drawCount + 1 : 0;
+                    if (moveNumber >= settings.drawMoveNumber && drawCount >= 2 * settings.drawMoveCount) {
+                        GameResult draw;
+                        draw.result = "1/2-1/2";
+                        draw.termination = "adjudication";
+                        draw.reason = "Draw by adjudication";
+                        return finishWith(draw, whiteName, blackName, round);
+                    }
+                }
+            }
+        }
+
+    private:
+        const Settings& settings;
+        EngineProcess* players[2];
+        Board board;
+        std::string startFen;
+        std::vector<std::string> uciMoves, sanMoves;
+        std::vector<uint64_t> hashes;
+        int firstMoveNumber = 1;
+        bool blackStarts = false;
+        int moveNumber = 1;  // full move number of the current position
+
+        void record(const Move& move) {
+            sanMoves.push_back(Notation::toSan(board, move));
+            uciMoves.push_back(moveToUci(move));
+            if (board.getSideToMove() == Color::BLACK) moveNumber++;
+            board.makeMove(move);
+            hashes.push_back(board.getHash());
+        }
+
+        bool threefold() const {
+            int limit = std::min(static_cast<int>(hashes.size()) - 1, board.getHalfMoveClock());
+            int count = 0;
+            for (int i = 0; i <= limit; i++)
+                if (hashes[hashes.size() - 1 - i] == board.getHash()) count++;
+            return count >= 3;
+        }
+
+        bool gameOver(GameResult& r) {
+            MoveList legal;
+            MoveGenerator::generateLegalMoves(board, legal);
+            bool whiteToMove = board.getSideToMove() == Color::WHITE;
+            r.termination = "normal";
+            if (legal.empty()) {
+                if (board.isInCheck(board.getSideToMove())) {
+                    r.result = whiteToMove ? "0-1" : "1-0";
+                    r.reason = whiteToMove ? "Black mates" : "White mates";
+                } else {
+                    r.result = "1/2-1/2";
+                    r.reason = "Draw by stalemate";
+                }
+                return true;
+            }
+            r.result = "1/2-1/2";
+            if (board.isDrawByFiftyMoves())     { r.reason = "Draw by fifty moves rule"; return true; }
+            if (threefold())                    { r.reason = "Draw by 3-fold repetition"; return true; }
+            if (board.isInsufficientMaterial()) { r.reason = "Draw by insufficient mating material"; return true; }
+            if (static_cast<int>(sanMoves.size()) >= settings.maxPlies) {
+                r.termination = "adjudication";
+                r.reason = "Draw by move limit";
+                return true;
+            }
+            return false;
+        }
+
+        GameResult finish(Color loser, const std::string& termination, const std::string& what,
+                          const std::string& whiteName, const std::string& blackName, int round) {
+            GameResult r;
+            r.result = (loser == Color::WHITE) ? "0-1" : "1-0";
+            r.termination = termination;
+            r.reason = std::string(loser == Color::WHITE ? "White " : "Black ") + what;
+            return finishWith(r, whiteName, blackName, round);
+        }
+
+        GameResult finishWith(GameResult r, const std::string& whiteName,
+                              const std::string& blackName, int round) {
+            r.whiteScore = (r.result == "1-0") ? 1 : (r.result == "0-1") ? -1 : 0;
+
+            std::ostringstream pgn;
+            pgn << "[Event \"match\"]\n[Site \"?\"]\n[Date \"" << today() << "\"]\n"
+                << "[Round \"" << round << "\"]\n[White \"" << whiteName << "\"]\n"
+                << "[Black \"" << blackName << "\"]\n[Result \"" << r.result << "\"]\n";
+            if (startFen != START_FEN)
+                pgn << "[FEN \"" << startFen << "\"]\n[SetUp \"1\"]\n";
+            pgn << "[PlyCount \"" << sanMoves.size() << "\"]\n"
+                << "[TimeControl \"" << settings.tcLabel << "\"]\n"
+                << "[Termination \"" << r.termination << "\"]\n\n";
+
+            std::string text, lineText;
+            auto emit = [&](const std::string& token) {
+                if (!lineText.empty() && lineText.size() + 1 + token.size() > 79) {
+                    text += lineText + "\n";
+                    lineText.clear();
+                }
+                lineText += (lineText.empty() ? "" : " ") + token;
+            };
+            int number = firstMoveNumber;
+            bool white = !blackStarts;
+            for (size_t i = 0; i < sanMoves.size(); i++) {
+                if (white)      emit(std::to_string(number) + ". " + sanMoves[i]);
+                else if (i == 0) emit(std::to_string(number) + "... " + sanMoves[i]);
+                else            emit(sanMoves[i]);
+                if (!white) number++;
+                white = !white;
+            }
+            emit("{" + r.reason + "}");
+            emit(r.result);
+            pgn << text << lineText << "\n\n";
+            r.pgn = pgn.str();
+            return r;
+        }
+    };
+
+    // ---------------------------------------------------------------------
+    // Statistics
+    // ---------------------------------------------------------------------
+
+    double eloFromScore(double s) {
+        s = std::min(std::max(s, 1e-6), 1 - 1e-6);
+        return -400.0 * std::log10(1.0 / s - 1.0);
+    }
+
+    double scoreFromElo(double elo) { return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0)); }
+
+    struct Stats {
+        int wins = 0, losses = 0, draws = 0;
+
+        int games() const { return wins + losses + draws; }
+        double score() const { return games() ? (wins + 0.5 * draws) / games() : 0.5; }
+
+        // Per-game variance of the score
+        double variance() const {
+            int n = games();
+            if (!n) return 0;
+            double s = score();
+            return (wins * (1 - s) * (1 - s) + draws * (0.5 - s) * (0.5 - s) + losses * s * s) / n;
+        }
+
+        // Elo estimate and the half-width of its 95% confidence interval
+        void elo(double& estimate, double& error) const {
+            double s = score();
+            double margin = 1.959964 * std::sqrt(variance() / std::max(games(), 1));
+            estimate = eloFromScore(s);
+            error = (eloFromScore(s + margin) - eloFromScore(s - margin)) / 2;
+        }
+
+        // Log-likelihood ratio of elo1 against elo0, with the normal
+        // approximation to the trinomial (W/D/L) score distribution
+        double llr(double elo0, double elo1) const {
+            double var = variance();
+            if (games() < 2 || var <= 0) return 0;
+            double s0 = scoreFromElo(elo0), s1 = scoreFromElo(elo1);
+            return games() * (s1 - s0) * (2 * score() - s0 - s1) / (2 * var);
+        }
+    };
+
+    bool parseKeyValue(const std::string& arg, std::string& key, std::string& value) {
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos) return false;
+        key = arg.substr(0, eq);
+        value = arg.substr(eq + 1);
+        return true;
+    }
+
+    void usage(const char* program) {
+        std::fprintf(stderr,
+            "usage: %s --engine cmd=PATH [name=NAME] [option.NAME=VALUE ...]\n"
+            "          --engine cmd=PATH [name=NAME] [option.NAME=VALUE ...]\n"
+            "          [--openings FILE.epd|FILE.pgn] [--plies N] [--games N]\n"
+            "          [--concurrency N] [--tc BASE+INC] [--margin MS] [--maxplies N]\n"
+            "          [--draw movenumber=N movecount=N score=CP] [--resign movecount=N score=CP]\n"
+            "          [--sprt elo0=E elo1=E alpha=A beta=B] [--pgn FILE]\n",
+            program);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::vector<EngineConfig> engines;
+    Settings settings;
+    std::string openingsPath, pgnPath;
+    int openingPlies = 8;
+    int games = 0;
+    int concurrency = std::max(1u, std::thread::hardware_concurrency());
+
+    // Key=value words following a flag, up to the next flag
+    auto collect = [&](int& i) {
+        std::vector<std::pair<std::string, std::string>> pairs;
+        std::string key, value;
+        while (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0 &&
+               parseKeyValue(argv[i + 1], key, value)) {
+            pairs.emplace_back(key, value);
+            i++;
+        }
+        return pairs;
+    };
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--engine") {
+            EngineConfig config;
+            for (const auto& kv : collect(i)) {
+                if (kv.first == "cmd")                          config.command = kv.second;
+                else if (kv.first == "name")                    config.name = kv.second;
+                else if (kv.first.compare(0, 7, "option.") == 0) config.options.emplace_back(kv.first.substr(7), kv.second);
+            }
+            if (config.command.empty()) { usage(argv[0]); return 2; }
+            if (config.name.empty()) config.name = config.command.substr(config.command.find_last_of('/') + 1);
+            engines.push_back(config);
+        } else if (arg == "--openings" && hasValue) {
+            openingsPath = argv[++i];
+        } else if (arg == "--plies" && hasValue) {
+            openingPlies = std::atoi(argv[++i]);
+        } else if (arg == "--games" && hasValue) {
+            games = std::atoi(argv[++i]);
+        } else if (arg == "--concurrency" && hasValue) {
+            concurrency = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--tc" && hasValue) {
+            settings.tcLabel = argv[++i];
+            size_t plus = settings.tcLabel.find('+');
+            settings.baseMs = std::atof(settings.tcLabel.substr(0, plus).c_str()) * 1000;
+            settings.incMs = (plus == std::string::npos) ? 0 : std::atof(settings.tcLabel.c_str() + plus + 1) * 1000;
+        } else if (arg == "--margin" && hasValue) {
+            settings.marginMs = std::atoi(argv[++i]);
+        } else if (arg == "--maxplies" && hasValue) {
+            settings.maxPlies = std::atoi(argv[++i]);
+        } else if (arg == "--pgn" && hasValue) {
+            pgnPath = argv[++i];
+        } else if (arg == "--draw") {
+            for (const auto& kv : collect(i)) {
+                if (kv.first == "movenumber")     settings.drawMoveNumber = std::atoi(kv.second.c_str());
+                else if (kv.first == "movecount") settings.drawMoveCount = std::atoi(kv.second.c_str());
+                else if (kv.first == "score")     settings.drawScore = std::atoi(kv.second.c_str());
+            }
+        } else if (arg == "--resign") {
+            for (const auto& kv : collect(i)) {
+                if (kv.first == "movecount")  settings.resignMoveCount = std::atoi(kv.second.c_str());
+                else if (kv.first == "score") settings.resignScore = std::atoi(kv.second.c_str());
+            }
+        } else if (arg == "--sprt") {
+            settings.sprt = true;
+            for (const auto& kv : collect(i)) {
+                double v = std::atof(kv.second.c_str());
+                if (kv.first == "elo0")       settings.elo0 = v;
+                else if (kv.first == "elo1")  settings.elo1 = v;
+                else if (kv.first == "alpha") settings.alpha = v;
+                else if (kv.first == "beta")  settings.beta = v;
+            }
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (engines.size() != 2) { usage(argv[0]); return 2; }
+    if (engines[0].name == engines[1].name) {
+        engines[0].name += "-1";
+        engines[1].name += "-2";
+    }
+
+    std::vector<Opening> openings;
+    if (!openingsPath.empty()) {
+        bool isPgn = openingsPath.size() > 4 && openingsPath.compare(openingsPath.size() - 4, 4, ".pgn") == 0;
+        bool loaded = isPgn ? loadPgn(openingsPath, openingPlies, openings) : loadEpd(openingsPath, openings);
+        if (!loaded || openings.empty()) {
+            std::fprintf(stderr, "no openings read from %s\n", openingsPath.c_str());
+            return 2;
+        }
+    } else {
+        openings.push_back({START_FEN, {}});
+    }
+    if (games <= 0) games = 2 * static_cast<int>(openings.size());
+    concurrency = std::min(concurrency, games);
+
+    std::ofstream pgnFile;
+    if (!pgnPath.empty()) {
+        pgnFile.open(pgnPath, std::ios::app);
+        if (!pgnFile) {
+            std::fprintf(stderr, "cannot write %s\n", pgnPath.c_str());
+            return 2;
+        }
+    }
+
+    double lowerBound = std::log(settings.beta / (1 - settings.alpha));
+    double upperBound = std::log((1 - settings.beta) / settings.alpha);
+
+    std::mutex mutex;
+    Stats stats;
+    std::atomic<int> nextGame{0};
+    std::atomic<bool> stopMatch{false};
+    std::atomic<bool> startFailed{false};
+    int finished = 0;
+
+    // Games 2k and 2k+1 play the same opening with colours reversed
+    auto worker = [&] {
+        EngineProcess processes[2];
+        for (;;) {
+            if (stopMatch) return;
+            int g = nextGame++;
+            if (g >= games) return;
+
+            for (int e = 0; e < 2; e++) {
+                if (processes[e].running() && !processes[e].exited()) continue;
+                processes[e].stop();
+                if (!processes[e].start(engines[e])) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    std::fprintf(stderr, "cannot start engine %s (%s)\n",
+                                 engines[e].name.c_str(), engines[e].command.c_str());
+                    startFailed = stopMatch = true;
+                    return;
+                }
+            }
+
+            const Opening& opening = openings[(g / 2) % openings.size()];
+            int white = g % 2;  // index of the engine with white
+            Game game(&processes[white], &processes[1 - white], settings);
+            GameResult r = game.play(opening, engines[white].name, engines[1 - white].name, g + 1);
+            int firstScore = (white == 0) ? r.whiteScore : -r.whiteScore;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (firstScore > 0)      stats.wins++;
+            else if (firstScore < 0) stats.losses++;
+            else                     stats.draws++;
+            finished++;
+            if (pgnFile) pgnFile << r.pgn << std::flush;
+
+            double elo, error;
+            stats.elo(elo, error);
+            std::printf("Finished game %d (%s vs %s): %s {%s}\n", g + 1, engines[white].name.c_str(),
+                        engines[1 - white].name.c_str(), r.result.c_str(), r.reason.c_str());
+            std::printf("Score of %s vs %s: %d - %d - %d  [%.3f] %d  Elo %+.1f +/- %.1f",
+                        engines[0].name.c_str(), engines[1].name.c_str(), stats.wins, stats.losses,
+                        stats.draws, stats.score(), finished, elo, error);
+            if (settings.sprt) {
+                double llr = stats.llr(settings.elo0, settings.elo1);
+                std::printf("  LLR %.2f (%.2f, %.2f)", llr, lowerBound, upperBound);
+                if (llr >= upperBound || llr <= lowerBound) stopMatch = true;
+            }
+            std::printf("\n");
+            std::fflush(stdout);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < concurrency; t++) threads.emplace_back(worker);
+    for (std::thread& t : threads) t.join();
+    if (startFailed) return 1;
+
+    double elo, error;
+    stats.elo(elo, error);
+    std::printf("\n%s vs %s: %d games, +%d -%d =%d, score %.1f%%\n", engines[0].name.c_str(),
+                engines[1].name.c_str(), stats.games(), stats.wins, stats.losses, stats.draws,
+                100 * stats.score());
+    std::printf("Elo difference: %+.1f +/- %.1f (95%%)\n", elo, error);
+    if (settings.sprt) {
+        double llr = stats.llr(settings.elo0, settings.elo1);
+        const char* verdict = llr >= upperBound ? "H1 accepted" : llr <= lowerBound ? "H0 accepted" : "inconclusive";
+        std::printf("SPRT [%.1f, %.1f]: LLR %.2f (%.2f, %.2f) %s\n", settings.elo0, settings.elo1, llr,
+                    lowerBound, upperBound, verdict);
+    }
+    return 0;
+}
@@ -0,0 +1,202 @@
+// Microbenchmarks for the hot primitives: make/unmake, move generation,
+// attack tests, SEE and every evaluation term, over the bench position set.
+//
+//   micro_bench [samples] [ms per sample]     (defaults: 10, 100)
+//
+// Each benchmark gets one untimed warm-up pass, which also calibrates how
+// many passes over the corpus fill a sample, then `samples` timed samples.
+// Output is JSON on stdout: mean ns/op with the standard deviation and
+// variance across samples, so a change can be judged against the noise.
+#include "bench.h"
+#include "board.h"
+#include "endgame.h"
+#include "evaluate.h"
+#include "movegen.h"
+#include "search.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Results are folded in here so the optimizer cannot drop the work
+    volatile uint64_t sink = 0;
+
+    struct Result {
+        std::string name;
+        double mean = 0, stddev = 0, variance = 0, best = 0;
+        long long opsPerSample = 0;
+    };
+
+    double elapsedNs(Clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    // pass() runs the primitive once over the whole corpus and returns how
+    // many operations that was.
+    template <typename Pass>
+    Result measure(const std::string& name, Pass&& pass, int samples, double sampleMs) {
+        auto start = Clock::now();
+        long long warmupOps = pass();
+        double passNs = std::max(elapsedNs(start), 1.0);
+        int passes = std::max(1, static_cast<int>(sampleMs * 1e6 / passNs));
+
+        std::vector<double> nsPerOp;
+        long long ops = 0;
+        for (int s = 0; s < samples; s++) {
+            ops = 0;
+            start = Clock::now();
+            for (int p = 0; p < passes; p++) ops += pass();
+            nsPerOp.push_back(elapsedNs(start) / std::max(ops, 1LL));
+        }
+
+        Result r;
+        r.name = name;
+        r.opsPerSample = ops ? ops : warmupOps;
+        for (double x : nsPerOp) r.mean += x;
+        r.mean /= nsPerOp.size();
+        for (double x : nsPerOp) r.variance += (x - r.mean) * (x - r.mean);
+        if (nsPerOp.size() > 1) r.variance /= nsPerOp.size() - 1;
+        r.stddev = std::sqrt(r.variance);
+        r.best = *std::min_element(nsPerOp.begin(), nsPerOp.end());
+        return r;
+    }
+
+    // An evaluation term that accumulates into mg/eg
+    template <typename Term>
+    long long evalTermPass(std::vector<Board>& boards, Term term) {
+        for (const Board& b : boards) {
+            int mg = 0, eg = 0;
+            term(b, mg, eg);
+            sink = sink + mg + eg;
+        }
+        return static_cast<long long>(boards.size());
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int samples     = argc > 1 ? std::max(2, std::atoi(argv[1])) : 10;
+    double sampleMs = argc > 2 ? std::max(1.0, std::atof(argv[2])) : 100.0;
+
+    std::vector<Board> boards;
+    std::vector<std::vector<Move>> legal, captures;
+    for (const std::string& fen : Benchmark::positions()) {
+        Board b;
+        b.fromFEN(fen);
+        boards.push_back(b);
+        legal.push_back(MoveGenerator::generateLegalMoves(b));
+        std::vector<Move> caps;
+        for (const Move& m : legal.back())
+            if (m.isCapture) caps.push_back(m);
+        captures.push_back(caps);
+    }
+
+    SearchEngine engine;
+    MoveList list;
+    std::vector<Result> results;
+
+    results.push_back(measure("makeMove+unmakeMove", [&] {
+        long long ops = 0;
+        for (size_t i = 0; i < boards.size(); i++)
+            for (const Move& m : legal[i]) {
+                boards[i].makeMove(m);
+                boards[i].unmakeMove(m);
+                ops++;
+            }
+        sink = sink + boards[0].getHash();
+        return ops;
+    }, samples, sampleMs));
+
+    results.push_back(measure("generatePseudoLegalMoves", [&] {
+        for (const Board& b : boards) {
+            MoveGenerator::generatePseudoLegalMoves(b, list);
+            sink = sink + list.size();
+        }
+        return static_cast<long long>(boards.size());
+    }, samples, sampleMs));
+
+    results.push_back(measure("generateLegalMoves", [&] {
+        for (const Board& b : boards) {
+            MoveGenerator::generateLegalMoves(b, list);
+            sink = sink + list.size();
+        }
+        return static_cast<long long>(boards.size());
+    }, samples, sampleMs));
+
+    results.push_back(measure("isSquareAttacked", [&] {
+        long long ops = 0;
+        for (const Board& b : boards)
+            for (Square sq = 0; sq < 64; sq++) {
+                sink = sink + b.isSquareAttacked(sq, Color::WHITE) + b.isSquareAttacked(sq, Color::BLACK);
+                ops += 2;
+            }
+        return ops;
+    }, samples, sampleMs));
+
+    results.push_back(measure("see", [&] {
+        long long ops = 0;
+        for (size_t i = 0; i < boards.size(); i++)
+            for (const Move& m : captures[i]) {
+                sink = sink + engine.see(boards[i], m);
+                ops++;
+            }
+        return ops;
+    }, samples, sampleMs));
+
+    results.push_back(measure("evaluate", [&] {
+        for (const Board& b : boards) sink = sink + Evaluation::evaluate(b);
+        return static_cast<long long>(boards.size());
+    }, samples, sampleMs));
+
+    results.push_back(measure("eval.material", [&] {
+        return evalTermPass(boards, [](const Board& b, int& mg, int& eg) {
+            int w = 0, bl = 0;
+            Evaluation::material(b, mg, eg, w, bl);
+        });
+    }, samples, sampleMs));
+
+    results.push_back(measure("eval.mobilityAndKingSafety", [&] {
+        return evalTermPass(boards, Evaluation::mobilityAndKingSafety);
+    }, samples, sampleMs));
+
+    results.push_back(measure("eval.rookFiles", [&] {
+        return evalTermPass(boards, Evaluation::rookFiles);
+    }, samples, sampleMs));
+
+    results.push_back(measure("eval.pawnStructure", [&] {
+        return evalTermPass(boards, Evaluation::pawnStructure);
+    }, samples, sampleMs));
+
+    results.push_back(measure("eval.kingShelter", [&] {
+        return evalTermPass(boards, [](const Board& b, int& mg, int&) { mg += Evaluation::kingShelter(b); });
+    }, samples, sampleMs));
+
+    results.push_back(measure("eval.gamePhase", [&] {
+        return evalTermPass(boards, [](const Board& b, int& mg, int&) { mg += Evaluation::gamePhase(b); });
+    }, samples, sampleMs));
+
+    results.push_back(measure("eval.endgames", [&] {
+        return evalTermPass(boards, [](const Board& b, int& mg, int&) {
+            int score = 0;
+            if (Endgames::evaluate(b, score)) mg += score;
+        });
+    }, samples, sampleMs));
+
+    std::printf("{\n  \"positions\": %zu,\n  \"samples\": %d,\n  \"benchmarks\": [\n",
+                boards.size(), samples);
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        std::printf("    {\"name\": \"%s\", \"ns_per_op\": %.2f, \"stddev\": %.2f, "
+                    "\"variance\": %.3f, \"min\": %.2f, \"ops_per_sample\": %lld}%s\n",
+                    r.name.c_str(), r.mean, r.stddev, r.variance, r.best, r.opsPerSample,
+                    i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+    return 0;
+}
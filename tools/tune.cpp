@@ -0,0 +1,424 @@
+// Texel tuning of the evaluation weights against game results.
+//
+//   tune <positions file> [--threads N] [--iterations N] [--rate R]
+//        [--k K] [--only FIELD,...] [--report N] [--out FILE]
+//
+// Each line of the input holds a FEN and the game result from white's side,
+// in any of the usual spellings: [1.0] [0.5] [0.0], 1-0 0-1 1/2-1/2, or an
+// EPD c9 "1-0" operation. Quiet positions give the best fit. A file ending
+// in .bin is read as PackedPosition records (chess_engine datagen).
+//
+// Every position is traced once at load time into the coefficients of the
+// weights (Evaluation::trace), so evaluating it under new weights is a
+// short dot product rather than a call into the engine. The positions are
+// split into one shard per thread; each pass has every thread sum the loss
+// and gradient over its own shard, and the partial sums are added at the
+// end. K, the scale from centipawns to expected score, is fitted to the
+// starting weights first, then the weights are fitted by Adam on the mean
+// squared error of sigmoid(K * eval) against the result. The tuned weights
+// are printed as an initializer for Evaluation::params.
+#include "board.h"
+#include "endgame.h"
+#include "evaluate.h"
+#include "packed_position.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    // EvalParams, member by member, for --only and the output
+    struct Field {
+        const char* name;
+        int index;
+        int count;
+        int rows;    // > 1 for the piece-square tables
+    };
+
+    #define FIELD(name, count, rows) {#name, evalParamIndex(offsetof(EvalParams, name)), count, rows}
+    constexpr Field FIELDS[] = {
+        FIELD(pieceMG, 5, 1),          FIELD(pieceEG, 5, 1),
+        FIELD(pstMG, 6 * 64, 6),       FIELD(pstEG, 6 * 64, 6),
+        FIELD(bishopPairMG, 1, 1),     FIELD(bishopPairEG, 1, 1),
+        FIELD(mobilityMG, 4, 1),       FIELD(mobilityEG, 4, 1),
+        FIELD(attackWeight, 4, 1),
+        FIELD(pawnAttackWeight, 1, 1), FIELD(defenderWeight, 1, 1),
+        FIELD(stormByRankDist, 8, 1),
+        FIELD(openLineOnFile, 1, 1),   FIELD(openLineBeside, 1, 1),
+        FIELD(attackRamp, 8, 1),       FIELD(attackRampNew, 8, 1),
+        FIELD(kingDangerScale, 1, 1),
+        FIELD(rookSemiOpenMG, 1, 1),   FIELD(rookSemiOpenEG, 1, 1),
+        FIELD(rookOpenMG, 1, 1),       FIELD(rookOpenEG, 1, 1),
+        FIELD(doubledMG, 1, 1),        FIELD(doubledEG, 1, 1),
+        FIELD(isolatedMG, 1, 1),       FIELD(isolatedEG, 1, 1),
+        FIELD(passedMG, 8, 1),         FIELD(passedEG, 8, 1),
+        FIELD(shieldNear, 1, 1),       FIELD(shieldFar, 1, 1),
+        FIELD(shieldMissing, 1, 1),
+    };
+    #undef FIELD
+
+    constexpr int fieldTotal() {
+        int n = 0;
+        for (const Field& f : FIELDS) n += f.count;
+        return n;
+    }
+    static_assert(fieldTotal() == EVAL_PARAM_COUNT, "FIELDS must list every EvalParams member");
+
+    const int KING_SCALE_INDEX = evalParamIndex(offsetof(EvalParams, kingDangerScale));
+
+    // One traced position. Its coefficients are the entries
+    // [coefBegin, coefBegin + coefCount) of the shard's coefs, then
+    // kingCount[0] and kingCount[1] entries of kingCoefs for each king.
+    struct Coef {
+        uint16_t index;
+        int16_t mg, eg;
+    };
+
+    struct KingCoef {
+        uint16_t index;
+        int16_t units;
+    };
+
+    struct Entry {
+        uint32_t coefBegin, kingBegin;
+        uint16_t coefCount;
+        uint16_t kingCount[2];
+        uint16_t ramp[2];
+        int16_t fixedEG;
+        uint8_t phase, scale;
+        float result;
+    };
+
+    struct Shard {
+        std::vector<Entry> entries;
+        std::vector<Coef> coefs;
+        std::vector<KingCoef> kingCoefs;
+        double checkError = 0, checkMax = 0;   // traced vs engine eval
+        size_t skipped = 0;
+    };
+
+    // Result from white's side, or -1 if the line has none
+    double parseResult(const std::string& rest) {
+        static const struct { const char* text; double value; } forms[] = {
+            {"[1.0]", 1.0}, {"[0.5]", 0.5}, {"[0.0]", 0.0}, {"[1]", 1.0}, {"[0]", 0.0},
+            {"1/2-1/2", 0.5}, {"1-0", 1.0}, {"0-1", 0.0},
+        };
+        for (const auto& f : forms)
+            if (rest.find(f.text) != std::string::npos) return f.value;
+        return -1;
+    }
+
+    bool parseLine(const std::string& line, Board& board, double& result) {
+        std::istringstream iss(line);
+        std::vector<std::string> fields;
+        std::string w;
+        while (fields.size() < 6 && iss >> w) fields.push_back(w);
+        if (fields.size() < 4) return false;
+
+        // Move counters are optional (EPD)
+        size_t used = 4;
+        auto numeric = [](const std::string& s) {
+            return !s.empty() && s.find_first_not_of("0123456789") == std::string::npos;
+        };
+        if (fields.size() >= 6 && numeric(fields[4]) && numeric(fields[5])) used = 6;
+        std::string fen = fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3];
+        fen += (used == 6) ? " " + fields[4] + " " + fields[5] : " 0 1";
+
+        size_t pos = 0;
+        for (size_t i = 0; i < used; i++) {
+            pos = line.find_first_not_of(" \t", pos);
+            pos = line.find_first_of(" \t", pos);
+        }
+        result = parseResult(pos == std::string::npos ? "" : line.substr(pos));
+        return result >= 0 && board.fromFEN(fen);
+    }
+
+    // Evaluation of a traced position under weights p. With grad set, also
+    // adds scale * d(eval)/d(weight) to it.
+    double evaluate(const Shard& shard, const Entry& e, const double* p,
+                    double* grad = nullptr, double scale = 0) {
+        double mgW = e.phase / 24.0;
+        double egW = (24 - e.phase) / 24.0 * e.scale / Endgames::SCALE_NORMAL;
+
+        double mg = 0, eg = e.fixedEG;
+        const Coef* c = &shard.coefs[e.coefBegin];
+        for (int i = 0; i < e.coefCount; i++) {
+            mg += c[i].mg * p[c[i].index];
+            eg += c[i].eg * p[c[i].index];
+            if (grad) grad[c[i].index] += scale * (c[i].mg * mgW + c[i].eg * egW);
+        }
+
+        const KingCoef* k = &shard.kingCoefs[e.kingBegin];
+        for (int side = 0; side < 2; side++) {
+            double units = 0;
+            for (int i = 0; i < e.kingCount[side]; i++) units += k[i].units * p[k[i].index];
+            if (units > 0) {
+                double ramp = p[e.ramp[side]], kingScale = p[KING_SCALE_INDEX];
+                double sign = side == 0 ? -1 : 1;
+                mg += sign * units * ramp * kingScale / 1e4;
+                if (grad) {
+                    double s = scale * sign * mgW / 1e4;
+                    for (int i = 0; i < e.kingCount[side]; i++)
+                        grad[k[i].index] += s * k[i].units * ramp * kingScale;
+                    grad[e.ramp[side]]    += s * units * kingScale;
+                    grad[KING_SCALE_INDEX] += s * units * ramp;
+                }
+            }
+            k += e.kingCount[side];
+        }
+        return mg * mgW + eg * egW;
+    }
+
+    double sigmoid(double k, double eval) { return 1.0 / (1.0 + std::pow(10.0, -k * eval / 400.0)); }
+
+    // Traces lines [begin, end) into shard
+    void load(const std::vector<std::string>& lines, size_t begin, size_t end, const double* p, Shard& shard) {
+        std::unique_ptr<EvalTrace> trace(new EvalTrace);
+        Board board;
+        for (size_t i = begin; i < end; i++) {
+            double result = 0.5;
+            if (!parseLine(lines[i], board, result) || !Evaluation::trace(board, *trace)) {
+                shard.skipped++;
+                continue;
+            }
+            const EvalTrace& t = *trace;
+            Entry e{};
+            e.coefBegin = static_cast<uint32_t>(shard.coefs.size());
+            for (int j = 0; j < EVAL_PARAM_COUNT; j++)
+                if (t.mg[j] || t.eg[j])
+                    shard.coefs.push_back({static_cast<uint16_t>(j), static_cast<int16_t>(t.mg[j]),
+                                           static_cast<int16_t>(t.eg[j])});
+            e.coefCount = static_cast<uint16_t>(shard.coefs.size() - e.coefBegin);
+            e.kingBegin = static_cast<uint32_t>(shard.kingCoefs.size());
+            for (int side = 0; side < 2; side++) {
+                for (int j = 0; j < EVAL_PARAM_COUNT; j++)
+                    if (t.kingUnits[side][j])
+                        shard.kingCoefs.push_back({static_cast<uint16_t>(j),
+                                                   static_cast<int16_t>(t.kingUnits[side][j])});
+                e.kingCount[side] = static_cast<uint16_t>(shard.kingCoefs.size() - e.kingBegin) -
+                                    (side ? e.kingCount[0] : 0);
+                e.ramp[side] = static_cast<uint16_t>(t.rampIndex[side]);
+            }
+            e.fixedEG = static_cast<int16_t>(t.fixedEG);
+            e.phase = static_cast<uint8_t>(t.phase);
+            e.scale = static_cast<uint8_t>(t.scale);
+            e.result = static_cast<float>(result);
+            shard.entries.push_back(e);
+
+            double diff = std::abs(evaluate(shard, e, p) - Evaluation::evaluate(board));
+            shard.checkError += diff;
+            shard.checkMax = std::max(shard.checkMax, diff);
+        }
+    }
+
+    // Runs fn(shard index) on one thread per shard
+    template <typename Fn>
+    void parallel(size_t shards, Fn&& fn) {
+        std::vector<std::thread> threads;
+        for (size_t s = 0; s < shards; s++) threads.emplace_back(fn, s);
+        for (std::thread& t : threads) t.join();
+    }
+
+    size_t countEntries(const std::vector<Shard>& shards) {
+        size_t n = 0;
+        for (const Shard& s : shards) n += s.entries.size();
+        return n;
+    }
+
+    // Mean squared error, and its gradient when grad is set
+    double loss(const std::vector<Shard>& shards, const double* p, double k, double* grad) {
+        std::vector<double> partialLoss(shards.size());
+        std::vector<std::vector<double>> partialGrad(shards.size());
+        parallel(shards.size(), [&](size_t s) {
+            double sum = 0;
+            std::vector<double>& g = partialGrad[s];
+            if (grad) g.assign(EVAL_PARAM_COUNT, 0.0);
+            const double dSigma = k * std::log(10.0) / 400.0;
+            for (const Entry& e : shards[s].entries) {
+                double sig = sigmoid(k, evaluate(shards[s], e, p));
+                double err = sig - e.result;
+                sum += err * err;
+                if (grad) evaluate(shards[s], e, p, g.data(), 2 * err * sig * (1 - sig) * dSigma);
+            }
+            partialLoss[s] = sum;
+        });
+
+        double n = static_cast<double>(std::max<size_t>(countEntries(shards), 1));
+        double total = 0;
+        for (double l : partialLoss) total += l;
+        if (grad) {
+            std::fill(grad, grad + EVAL_PARAM_COUNT, 0.0);
+            for (const auto& g : partialGrad)
+                for (int i = 0; i < EVAL_PARAM_COUNT; i++) grad[i] += g[i] / n;
+        }
+        return total / n;
+    }
+
+    // Golden-section search for the K that best fits the starting weights
+    double fitK(const std::vector<Shard>& shards, const double* p) {
+        double lo = 0.05, hi = 5.0;
+        const double ratio = (std::sqrt(5.0) - 1) / 2;
+        double a = hi - ratio * (hi - lo), b = lo + ratio * (hi - lo);
+        double la = loss(shards, p, a, nullptr), lb = loss(shards, p, b, nullptr);
+        for (int i = 0; i < 40; i++) {
+            if (la < lb) { hi = b; b = a; lb = la; a = hi - ratio * (hi - lo); la = loss(shards, p, a, nullptr); }
+            else         { lo = a; a = b; la = lb; b = lo + ratio * (hi - lo); lb = loss(shards, p, b, nullptr); }
+        }
+        return (lo + hi) / 2;
+    }
+
+    void writeParams(std::FILE* out, const double* p) {
+        std::fprintf(out, "EvalParams Evaluation::params = {\n");
+        for (size_t f = 0; f < sizeof(FIELDS) / sizeof(FIELDS[0]); f++) {
+            const Field& field = FIELDS[f];
+            const char* sep = (f + 1 < sizeof(FIELDS) / sizeof(FIELDS[0])) ? "," : "";
+            auto value = [&](int i) { return static_cast<int>(std::lround(p[field.index + i])); };
+            std::fprintf(out, "    // %s\n", field.name);
+            if (field.count == 1) {
+                std::fprintf(out, "    %d%s\n", value(0), sep);
+            } else if (field.rows == 1) {
+                std::fprintf(out, "    {");
+                for (int i = 0; i < field.count; i++) std::fprintf(out, "%s%d", i ? ", " : "", value(i));
+                std::fprintf(out, "}%s\n", sep);
+            } else {
+                int perRow = field.count / field.rows;
+                std::fprintf(out, "    {\n");
+                for (int r = 0; r < field.rows; r++) {
+                    std::fprintf(out, "        {\n");
+                    for (int i = 0; i < perRow; i++)
+                        std::fprintf(out, "%s%4d%s", i % 8 ? "" : "            ", value(r * perRow + i),
+                                     i + 1 < perRow ? (i % 8 == 7 ? ",\n" : ",") : "\n");
+                    std::fprintf(out, "        }%s\n", r + 1 < field.rows ? "," : "");
+                }
+                std::fprintf(out, "    }%s\n", sep);
+            }
+        }
+        std::fprintf(out, "};\n");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <positions> [--threads N] [--iterations N] [--rate R] [--k K]\n"
+                             "          [--only FIELD,...] [--report N] [--out FILE]\n", argv[0]);
+        return 2;
+    }
+
+    std::string path = argv[1], outPath, only;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    int iterations = 1000, report = 50;
+    double rate = 1.0, k = 0;
+    for (int i = 2; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--threads") && hasValue)         threads = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--iterations") && hasValue) iterations = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--rate") && hasValue)       rate = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--k") && hasValue)          k = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--only") && hasValue)       only = argv[++i];
+        else if (!std::strcmp(argv[i], "--report") && hasValue)     report = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--out") && hasValue)        outPath = argv[++i];
+    }
+
+    std::vector<double> params(EVAL_PARAM_COUNT);
+    const int* current = reinterpret_cast<const int*>(&Evaluation::params);
+    for (int i = 0; i < EVAL_PARAM_COUNT; i++) params[i] = current[i];
+
+    // Which weights move: all, or the fields named in --only
+    std::vector<bool> active(EVAL_PARAM_COUNT, only.empty());
+    std::stringstream names(only);
+    std::string name;
+    while (std::getline(names, name, ',')) {
+        bool found = false;
+        for (const Field& f : FIELDS)
+            if (name == f.name) {
+                std::fill(active.begin() + f.index, active.begin() + f.index + f.count, true);
+                found = true;
+            }
+        if (!found) { std::fprintf(stderr, "unknown field: %s\n", name.c_str()); return 2; }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto seconds = [&] {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::vector<std::string> lines;
+    bool packed = path.size() > 4 && path.compare(path.size() - 4, 4, ".bin") == 0;
+    if (packed) {
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) { std::fprintf(stderr, "cannot read %s\n", path.c_str()); return 2; }
+        PackedPosition p;
+        while (std::fread(&p, sizeof(p), 1, file) == 1)
+            lines.push_back(p.toFEN() + (p.result > 0 ? " [1.0]" : p.result < 0 ? " [0.0]" : " [0.5]"));
+        std::fclose(file);
+    } else {
+        std::ifstream file(path);
+        if (!file) { std::fprintf(stderr, "cannot read %s\n", path.c_str()); return 2; }
+        std::string line;
+        while (std::getline(file, line))
+            if (!line.empty()) lines.push_back(line);
+    }
+    threads = static_cast<int>(std::min<size_t>(threads, std::max<size_t>(lines.size(), 1)));
+
+    std::vector<Shard> shards(threads);
+    parallel(shards.size(), [&](size_t s) {
+        load(lines, lines.size() * s / threads, lines.size() * (s + 1) / threads, params.data(), shards[s]);
+    });
+    lines.clear();
+    lines.shrink_to_fit();
+
+    size_t positions = countEntries(shards), skipped = 0;
+    double checkError = 0, checkMax = 0;
+    for (const Shard& s : shards) {
+        skipped += s.skipped;
+        checkError += s.checkError;
+        checkMax = std::max(checkMax, s.checkMax);
+    }
+    if (!positions) { std::fprintf(stderr, "no usable positions in %s\n", path.c_str()); return 2; }
+    // The traced eval skips the engine's integer rounding; anything more
+    // than a few centipawns means trace() and evaluate() disagree
+    std::printf("%zu positions (%zu skipped) in %.1fs, trace check: mean |diff| %.2f cp, max %.1f cp\n",
+                positions, skipped, seconds(), checkError / positions, checkMax);
+
+    if (k <= 0) k = fitK(shards, params.data());
+    std::printf("K = %.4f, loss %.6f\n", k, loss(shards, params.data(), k, nullptr));
+    std::fflush(stdout);
+
+    // Adam
+    const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+    std::vector<double> grad(EVAL_PARAM_COUNT), m(EVAL_PARAM_COUNT, 0.0), v(EVAL_PARAM_COUNT, 0.0);
+    for (int it = 1; it <= iterations; it++) {
+        double l = loss(shards, params.data(), k, grad.data());
+        for (int i = 0; i < EVAL_PARAM_COUNT; i++) {
+            if (!active[i]) continue;
+            m[i] = beta1 * m[i] + (1 - beta1) * grad[i];
+            v[i] = beta2 * v[i] + (1 - beta2) * grad[i] * grad[i];
+            double mHat = m[i] / (1 - std::pow(beta1, it));
+            double vHat = v[i] / (1 - std::pow(beta2, it));
+            params[i] -= rate * mHat / (std::sqrt(vHat) + epsilon);
+        }
+        if (it % report == 0 || it == iterations) {
+            std::printf("iteration %d, loss %.6f, %.1fs\n", it, l, seconds());
+            std::fflush(stdout);
+            if (!outPath.empty()) {
+                if (std::FILE* out = std::fopen(outPath.c_str(), "w")) {
+                    writeParams(out, params.data());
+                    std::fclose(out);
+                }
+            }
+        }
+    }
+
+    if (outPath.empty()) writeParams(stdout, params.data());
+    return 0;
+}